@@ -0,0 +1,103 @@
+#include "autopilot.h"
+
+#include <stdlib.h>
+
+// Bullets further than this many ticks away are not a threat yet
+#define AUTOPILOT_HORIZON 60
+
+// Extra room kept between the ship and a bullet, in pixels
+#define AUTOPILOT_MARGIN 6
+
+// How much the alien bullets threaten the ship if it keeps moving in a
+// direction (-1, 0 or 1): a bullet counts if it would overlap the ship on
+// any tick it spends level with it, the sooner the more
+static double Danger(const Game* game, int direction) {
+    int speed = game->config.playerSpeed;
+    int bulletSpeed = game->config.alienBulletSpeed;
+    int maxX = game->config.worldWidth - PLAYER_WIDTH;
+    double danger = 0.0;
+    for (int i = 0; i < game->alienBulletPool.count; i++) {
+        const Bullet* bullet = &game->alienBullets[i];
+        int first = (game->playerY - bullet->y) / bulletSpeed;
+        int last = (game->playerY + PLAYER_HEIGHT - bullet->y) / bulletSpeed;
+        if (last < 0 || first > AUTOPILOT_HORIZON) {
+            continue;
+        }
+        if (first < 0) first = 0;
+        for (int ticks = first; ticks <= last + 1; ticks++) {
+            int x = game->playerX + direction * speed * ticks;
+            if (x < 0) x = 0;
+            if (x > maxX) x = maxX;
+            if (bullet->x >= x - AUTOPILOT_MARGIN && bullet->x <= x + PLAYER_WIDTH + AUTOPILOT_MARGIN) {
+                danger += 1.0 / (1 + first);
+                break;
+            }
+        }
+    }
+    return danger;
+}
+
+// Where a bullet fired now should go: the middle of the column with the
+// lowest live alien (nearest one on ties), led by how far the formation
+// drifts while the bullet climbs. False when no alien is left.
+static bool PickTarget(const Game* game, int* targetX) {
+    const Formation* formation = &game->formation;
+    int center = game->playerX + PLAYER_WIDTH / 2;
+    int best = -1, bestRow = -1, bestDistance = 0;
+    for (int i = 0; i < formation->liveColumnCount; i++) {
+        int col = formation->liveColumns[i];
+        int row = formation->lowestRow[col];
+        int distance = abs(AlienX(formation, col) + formation->width / 2 - center);
+        if (row > bestRow || (row == bestRow && distance < bestDistance)) {
+            best = col;
+            bestRow = row;
+            bestDistance = distance;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+
+    int climb = (game->playerY - AlienY(formation, bestRow)) / game->config.playerBulletSpeed;
+    int drift = climb * game->config.alienMoveSpeed / (game->alienMoveDelay > 0 ? game->alienMoveDelay : 1);
+    *targetX = AlienX(formation, best) + formation->width / 2 + (game->alienDirection == DIR_RIGHT ? drift : -drift);
+    return true;
+}
+
+int AutopilotInputs(const Game* game, GameInput* inputs) {
+    int count = 0;
+    if (game->state == GAME_MENU) {
+        inputs[count++] = INPUT_FIRE;
+        return count;
+    }
+    if (game->state != GAME_PLAYING) {
+        return count;
+    }
+
+    int targetX = game->playerX + PLAYER_WIDTH / 2;
+    bool aiming = PickTarget(game, &targetX);
+    int offset = targetX - (game->playerX + PLAYER_WIDTH / 2);
+    int preferred = offset > game->config.playerSpeed / 2 ? 1 : (offset < -game->config.playerSpeed / 2 ? -1 : 0);
+
+    // Safest direction, the one toward the target when it is as safe
+    double danger[3];
+    for (int candidate = -1; candidate <= 1; candidate++) {
+        danger[candidate + 1] = Danger(game, candidate);
+    }
+    int direction = preferred;
+    for (int candidate = -1; candidate <= 1; candidate++) {
+        if (danger[candidate + 1] < danger[direction + 1]) {
+            direction = candidate;
+        }
+    }
+    if (direction < 0) {
+        inputs[count++] = INPUT_LEFT;
+    } else if (direction > 0) {
+        inputs[count++] = INPUT_RIGHT;
+    }
+
+    if (aiming && abs(offset) <= game->formation.width / 2 - 4) {
+        inputs[count++] = INPUT_FIRE;
+    }
+    return count;
+}
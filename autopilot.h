@@ -0,0 +1,11 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "game.h"
+
+// Autopilot: a player that reads the game state, dodges the alien bullets
+// coming its way and shoots the column whose lowest alien is the lowest.
+// Same calling convention as ScriptedInputs.
+int AutopilotInputs(const Game* game, GameInput* inputs);
+
+#endif
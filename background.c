@@ -0,0 +1,127 @@
+#include "background.h"
+
+#include <string.h>
+
+#include "rng.h"
+
+// Background draws come from their own stream, never the gameplay one
+#define BACKGROUND_STREAM 0xB6
+
+// Build the list of stars and nebula dots
+void GenerateBackground(Background* background, int width, int height, uint64_t seed) {
+    Rng rng;
+    SeedRandom(&rng, seed, BACKGROUND_STREAM);
+    background->dotCount = 0;
+    background->starCount = STAR_COUNT;
+    background->width = width;
+    background->height = height;
+
+    // Stars
+    for (int i = 0; i < STAR_COUNT; i++) {
+        BackgroundDot* dot = &background->dots[background->dotCount++];
+        dot->x = RandomRange(&rng, width);
+        dot->y = RandomRange(&rng, height);
+        dot->size = RandomRange(&rng, 3) + 1;
+        dot->color = FB_RGB(255, 255, 255);
+    }
+
+    // Some distant galaxies/nebulae, drawn as small dots to fake low alpha
+    for (int i = 0; i < NEBULA_COUNT; i++) {
+        int x = RandomRange(&rng, width);
+        int y = RandomRange(&rng, height);
+        int size = RandomRange(&rng, 50) + 20;
+
+        uint32_t galaxyColor;
+        switch (RandomRange(&rng, 3)) {
+            case 0: galaxyColor = FB_RGB(50, 50, 150); break; // Blue
+            case 1: galaxyColor = FB_RGB(150, 50, 150); break; // Purple
+            default: galaxyColor = FB_RGB(150, 50, 50); break; // Red
+        }
+
+        for (int j = 0; j < NEBULA_DOTS; j++) {
+            BackgroundDot* dot = &background->dots[background->dotCount++];
+            dot->x = x + RandomRange(&rng, size) - size/2;
+            dot->y = y + RandomRange(&rng, size) - size/2;
+            dot->size = RandomRange(&rng, 2) + 1;
+            dot->color = galaxyColor;
+        }
+    }
+}
+
+// Draw every dot, used to bake the layer once
+void DrawBackgroundDots(const Background* background, Framebuffer* fb) {
+    for (int i = 0; i < background->dotCount; i++) {
+        const BackgroundDot* dot = &background->dots[i];
+        FillEllipse(fb, dot->x, dot->y, dot->x + dot->size, dot->y + dot->size, dot->color);
+    }
+}
+
+// Draw dots [first, end) of a band of the layer into view, which starts at
+// layer row top
+static void DrawBackgroundBand(const Background* background, Framebuffer* view, int top, int first, int end) {
+    for (int i = first; i < end; i++) {
+        const BackgroundDot* dot = &background->dots[i];
+        int y = dot->y - top;
+        if (y + dot->size <= 0 || y >= view->height) {
+            continue;
+        }
+        FillEllipse(view, dot->x, y, dot->x + dot->size, y + dot->size, dot->color);
+    }
+}
+
+// Draw dots [first, end) straight into fb, scrolled like BlitBackground.
+// The rows below the wrap point and those above it are two views into fb,
+// so a dot is clipped to the layer exactly as the bake clipped it.
+static void DrawScrolledDots(const Background* background, Framebuffer* fb, int scrollY, int first, int end) {
+    int width = fb->width < background->width ? fb->width : background->width;
+    int height = fb->height < background->height ? fb->height : background->height;
+    int offset = scrollY % background->height;
+    if (offset < 0) offset += background->height;
+
+    if (offset < height) {
+        Framebuffer below = {fb->pixels + (size_t)offset * fb->stride, width, height - offset, fb->stride};
+        DrawBackgroundBand(background, &below, 0, first, end);
+    }
+    if (offset > 0) {
+        Framebuffer above = {fb->pixels, width, offset < height ? offset : height, fb->stride};
+        DrawBackgroundBand(background, &above, background->height - offset, first, end);
+    }
+}
+
+// Clear the background area of fb and draw the stars
+void DrawScrolledStars(const Background* background, Framebuffer* fb, int scrollY) {
+    Framebuffer view = {fb->pixels,
+                        fb->width < background->width ? fb->width : background->width,
+                        fb->height < background->height ? fb->height : background->height,
+                        fb->stride};
+    ClearFramebuffer(&view, FB_RGB(0, 0, 0));
+    DrawScrolledDots(background, fb, scrollY, 0, background->starCount);
+}
+
+// Draw the nebula dots over the stars
+void DrawScrolledNebulae(const Background* background, Framebuffer* fb, int scrollY) {
+    DrawScrolledDots(background, fb, scrollY, background->starCount, background->dotCount);
+}
+
+// Clear and draw the whole background straight into fb, giving the same
+// pixels as BlitBackground of a baked layer
+void DrawScrolledBackground(const Background* background, Framebuffer* fb, int scrollY) {
+    DrawScrolledStars(background, fb, scrollY);
+    DrawScrolledNebulae(background, fb, scrollY);
+}
+
+// Copy the baked layer, shifted down by scrollY and wrapped around
+void BlitBackground(Framebuffer* target, const Framebuffer* layer, int scrollY) {
+    int width = target->width < layer->width ? target->width : layer->width;
+    int height = target->height < layer->height ? target->height : layer->height;
+    int offset = scrollY % layer->height;
+    if (offset < 0) offset += layer->height;
+
+    for (int y = 0; y < height; y++) {
+        int sourceY = y - offset;
+        if (sourceY < 0) sourceY += layer->height;
+        memcpy(target->pixels + (size_t)y * target->stride,
+               layer->pixels + (size_t)sourceY * layer->stride,
+               width * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include <stdint.h>
+
+#include "framebuffer.h"
+
+// Starfield layout
+#define STAR_COUNT 200
+#define NEBULA_COUNT 5
+#define NEBULA_DOTS 30
+#define BACKGROUND_SEED 12345
+#define BACKGROUND_DOT_COUNT (STAR_COUNT + NEBULA_COUNT * NEBULA_DOTS)
+
+// Parallax scroll speed in pixels per second when enabled
+#define BACKGROUND_SCROLL_SPEED 8
+
+// One star or nebula dot, drawn as an ellipse
+typedef struct {
+    int x, y;
+    int size;
+    uint32_t color; // FB_RGB
+} BackgroundDot;
+
+// Static background description. It is generated once from its own random
+// generator, so building it never touches the gameplay random stream.
+typedef struct {
+    BackgroundDot dots[BACKGROUND_DOT_COUNT];
+    int dotCount;
+    int starCount; // dots before this are stars, the rest nebula dots
+    int width, height;
+} Background;
+
+void GenerateBackground(Background* background, int width, int height, uint64_t seed);
+void DrawBackgroundDots(const Background* background, Framebuffer* fb);
+void DrawScrolledStars(const Background* background, Framebuffer* fb, int scrollY);
+void DrawScrolledNebulae(const Background* background, Framebuffer* fb, int scrollY);
+void DrawScrolledBackground(const Background* background, Framebuffer* fb, int scrollY);
+void BlitBackground(Framebuffer* target, const Framebuffer* layer, int scrollY);
+
+#endif
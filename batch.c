@@ -0,0 +1,228 @@
+// Batch runner: plays many independent games on every core. Each worker
+// owns one Game, reused from job to job so its state stays in that core's
+// cache, and a queue of job indices. A worker whose queue runs dry steals
+// half of the jobs left in another one.
+#define _POSIX_C_SOURCE 200112L
+
+#include "batch.h"
+#include "autopilot.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BATCH_MAX_THREADS 256
+#define CACHE_LINE 64
+
+// Jobs [next, end) still waiting in a worker's queue. The owner takes from
+// the front, thieves take from the back.
+typedef struct {
+    pthread_mutex_t lock;
+    int next, end;
+} WorkQueue;
+
+typedef union {
+    WorkQueue queue;
+    char pad[(sizeof(WorkQueue) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE];
+} PaddedQueue;
+
+typedef struct BatchRun BatchRun;
+
+typedef struct {
+    BatchRun* run;
+    int index;
+    Game game;
+    long long ticks;
+    int steals;
+} Worker;
+
+struct BatchRun {
+    const BatchJob* jobs;
+    BatchResult* results;
+    int threadCount;
+    PaddedQueue* queues;
+    Worker* workers;
+};
+
+int BatchDefaultThreads(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) return 1;
+    if (cores > BATCH_MAX_THREADS) return BATCH_MAX_THREADS;
+    return (int)cores;
+}
+
+// Play one job to the end of its game (scripted, autopilot) or its log
+// (replay), timing each level from its first tick of play to the tick it
+// is cleared
+static void PlayJob(Game* game, const BatchJob* job, BatchResult* result) {
+    ReplayCursor cursor;
+    if (job->input == BATCH_INPUT_REPLAY) {
+        SeedGame(game, job->replay->seed);
+        StartReplay(&cursor, job->replay);
+    } else {
+        SeedGame(game, job->seed);
+    }
+    InitializeGame(game);
+    result->levelsCleared = 0;
+    uint32_t levelStart = 0;
+
+    while ((long)game->tick < job->maxTicks) {
+        if (job->input == BATCH_INPUT_REPLAY) {
+            if (!QueueReplayInputs(&cursor, game)) {
+                break;
+            }
+        } else {
+            GameInput inputs[MAX_PENDING_INPUTS];
+            int count = job->input == BATCH_INPUT_AUTOPILOT ? AutopilotInputs(game, inputs)
+                                                            : ScriptedInputs(game, inputs);
+            for (int i = 0; i < count; i++) {
+                QueueInput(game, inputs[i]);
+            }
+        }
+        GameState before = game->state;
+        int level = game->level;
+        UpdateGame(game);
+
+        if (before != GAME_PLAYING && game->state == GAME_PLAYING) {
+            levelStart = game->tick;
+        } else if (game->level > level && result->levelsCleared < MAX_LEVELS) {
+            result->clearTicks[result->levelsCleared++] = game->tick - levelStart;
+            levelStart = game->tick;
+        }
+        if (job->input != BATCH_INPUT_REPLAY && (game->state == GAME_OVER || game->state == GAME_WIN)) {
+            break;
+        }
+    }
+
+    result->ticks = game->tick;
+    result->state = game->state;
+    result->level = game->level;
+    result->score = game->score;
+    result->lives = game->playerLives;
+    result->hash = HashGame(game);
+}
+
+// Next job from the front of a worker's own queue, -1 when it is empty
+static int PopJob(WorkQueue* queue) {
+    int job = -1;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->next < queue->end) {
+        job = queue->next++;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return job;
+}
+
+// Move half of the jobs left in some other queue into the worker's own,
+// false when every queue is empty
+static bool StealJobs(Worker* worker) {
+    BatchRun* run = worker->run;
+    for (int offset = 1; offset < run->threadCount; offset++) {
+        WorkQueue* victim = &run->queues[(worker->index + offset) % run->threadCount].queue;
+        pthread_mutex_lock(&victim->lock);
+        int left = victim->end - victim->next;
+        int taken = (left + 1) / 2;
+        int first = victim->end - taken;
+        victim->end = first;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (taken > 0) {
+            WorkQueue* own = &run->queues[worker->index].queue;
+            pthread_mutex_lock(&own->lock);
+            own->next = first;
+            own->end = first + taken;
+            pthread_mutex_unlock(&own->lock);
+            worker->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void* WorkerMain(void* argument) {
+    Worker* worker = argument;
+    BatchRun* run = worker->run;
+    WorkQueue* own = &run->queues[worker->index].queue;
+    for (;;) {
+        int job = PopJob(own);
+        if (job < 0) {
+            if (!StealJobs(worker)) {
+                break;
+            }
+            continue;
+        }
+        PlayJob(&worker->game, &run->jobs[job], &run->results[job]);
+        worker->ticks += run->results[job].ticks;
+    }
+    return NULL;
+}
+
+// Play every job on the given number of threads, 0 for one per core.
+// results[i] belongs to jobs[i] whatever thread played it.
+bool RunBatch(const GameConfig* config, const BatchJob* jobs, BatchResult* results, int count,
+              int threads, BatchStats* stats) {
+    if (threads <= 0) threads = BatchDefaultThreads();
+    if (threads > BATCH_MAX_THREADS) threads = BATCH_MAX_THREADS;
+    if (threads > count) threads = count > 0 ? count : 1;
+
+    BatchRun run;
+    run.jobs = jobs;
+    run.results = results;
+    run.threadCount = threads;
+    run.queues = calloc((size_t)threads, sizeof(PaddedQueue));
+    run.workers = calloc((size_t)threads, sizeof(Worker));
+    pthread_t* handles = calloc((size_t)threads, sizeof(pthread_t));
+    bool ok = run.queues != NULL && run.workers != NULL && handles != NULL;
+
+    // Contiguous slices to start with, stealing evens them out
+    int queuesReady = ok ? threads : 0;
+    for (int w = 0; w < queuesReady; w++) {
+        WorkQueue* queue = &run.queues[w].queue;
+        pthread_mutex_init(&queue->lock, NULL);
+        queue->next = (int)((long long)count * w / threads);
+        queue->end = (int)((long long)count * (w + 1) / threads);
+    }
+    int created = 0;
+    for (int w = 0; w < threads && ok; w++) {
+        run.workers[w].run = &run;
+        run.workers[w].index = w;
+        if (!CreateGame(&run.workers[w].game, config)) {
+            ok = false;
+            break;
+        }
+        created++;
+    }
+
+    int started = 0;
+    for (int w = 0; w < created && ok; w++) {
+        if (pthread_create(&handles[w], NULL, WorkerMain, &run.workers[w]) != 0) {
+            ok = false;
+            break;
+        }
+        started++;
+    }
+    // Threads that did start still drain every queue before they stop
+    for (int w = 0; w < started; w++) {
+        pthread_join(handles[w], NULL);
+    }
+
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(BatchStats));
+        stats->threads = threads;
+        for (int w = 0; w < created; w++) {
+            stats->ticks += run.workers[w].ticks;
+            stats->steals += run.workers[w].steals;
+        }
+    }
+    for (int w = 0; w < created; w++) {
+        DestroyGame(&run.workers[w].game);
+    }
+    for (int w = 0; w < queuesReady; w++) {
+        pthread_mutex_destroy(&run.queues[w].queue.lock);
+    }
+    free(handles);
+    free(run.workers);
+    free(run.queues);
+    return ok && started > 0;
+}
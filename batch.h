@@ -0,0 +1,48 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "input.h"
+
+// Where a batched game gets its inputs from
+typedef enum {
+    BATCH_INPUT_SCRIPTED,  // the scripted player, seeded with the job seed
+    BATCH_INPUT_REPLAY,    // a recorded session, seeded with the log seed
+    BATCH_INPUT_AUTOPILOT  // the autopilot, seeded with the job seed
+} BatchInput;
+
+// One independent game to play
+typedef struct {
+    uint64_t seed;
+    BatchInput input;
+    const InputLog* replay; // BATCH_INPUT_REPLAY only, shared read-only
+    long maxTicks;          // stop here if the game is not over before
+} BatchJob;
+
+// How a game ended up
+typedef struct {
+    uint32_t ticks;
+    GameState state; // GAME_OVER or GAME_WIN when it finished, else still playing
+    int level;
+    int score;
+    int lives;
+    uint64_t hash;
+    int levelsCleared;
+    uint32_t clearTicks[MAX_LEVELS]; // ticks spent on each cleared level
+} BatchResult;
+
+// Totals of a batch run
+typedef struct {
+    int threads;
+    long long ticks;
+    int steals; // times a worker ran out and took jobs from another
+} BatchStats;
+
+int BatchDefaultThreads(void);
+bool RunBatch(const GameConfig* config, const BatchJob* jobs, BatchResult* results, int count,
+              int threads, BatchStats* stats);
+
+#endif
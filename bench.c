@@ -0,0 +1,3353 @@
+// Headless benchmark runner: drives the simulation without a window
+#define _POSIX_C_SOURCE 200112L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "game.h"
+#include "loop.h"
+#include "render_target.h"
+#include "background.h"
+#include "canvas.h"
+#include "command_buffer.h"
+#include "input.h"
+#include "particles.h"
+#include "profiler.h"
+#include "scene.h"
+#include "savestate.h"
+#include "snapshot.h"
+#include "sprites.h"
+#include "collision.h"
+
+// Benchmark entry
+typedef struct {
+    const char* name;
+    const char* description;
+    long defaultIterations;
+    bool (*run)(long iterations); // false when a built-in check fails
+} Benchmark;
+
+// Monotonic clock in nanoseconds
+static double NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Same clock as the profiler wants it
+static int64_t ClockNs(void) {
+    return (int64_t)NowNs();
+}
+
+// Results that must not be optimized away
+static volatile long benchSink;
+
+// Most benchmarks play the classic configuration
+static bool CreateClassicGame(Game* game) {
+    GameConfig config;
+    DefaultGameConfig(&config);
+    return CreateGame(game, &config);
+}
+
+// Feed the scripted player's inputs for the coming tick
+static void QueueScriptedInputs(Game* game) {
+    GameInput inputs[MAX_PENDING_INPUTS];
+    int count = ScriptedInputs(game, inputs);
+    for (int i = 0; i < count; i++) {
+        QueueInput(game, inputs[i]);
+    }
+}
+
+// Raw simulation throughput
+static bool BenchTicks(long ticks) {
+    static Game game;
+    long games = 0;
+    long checksum = 0;
+
+    if (!CreateClassicGame(&game)) {
+        return false;
+    }
+    SeedGame(&game, 1);
+    InitializeGame(&game);
+
+    double start = NowNs();
+    for (long tick = 0; tick < ticks; tick++) {
+        QueueScriptedInputs(&game);
+        GameState before = game.state;
+        UpdateGame(&game);
+        if (before == GAME_PLAYING && game.state != GAME_PLAYING) {
+            games++;
+            checksum += game.score;
+        }
+    }
+    double elapsed = NowNs() - start;
+
+    printf("ticks: %ld in %.3f s\n", ticks, elapsed / 1e9);
+    printf("  %.0f ticks/s, %.1f ns/tick\n", ticks / (elapsed / 1e9), elapsed / ticks);
+    printf("  %ld games finished, score checksum %ld\n", games, checksum);
+    DestroyGame(&game);
+    return true;
+}
+
+// Deterministic jitter source for the fake clock
+static unsigned int jitterState = 12345u;
+
+static int64_t FakeJitterNs(int64_t amplitudeNs) {
+    jitterState = jitterState * 1664525u + 1013904223u;
+    return (int64_t)((jitterState >> 8) % (2 * amplitudeNs + 1)) - amplitudeNs;
+}
+
+// Drive the fixed-timestep loop with a fake clock and check its guarantees
+static bool BenchLoop(long frames) {
+    bool ok = true;
+    FixedLoop loop;
+
+    // 60 Hz sim on a jittery 144 Hz display: tick count must follow wall time
+    InitFixedLoop(&loop, 60, DEFAULT_MAX_CATCH_UP);
+    int64_t now = 0;
+    int64_t frameNs = NS_PER_SECOND / 144;
+    AdvanceFixedLoop(&loop, now);
+    double start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        now += frameNs + FakeJitterNs(frameNs / 4);
+        AdvanceFixedLoop(&loop, now);
+    }
+    double elapsed = NowNs() - start;
+    long expected = (long)(now / loop.tickNs);
+    if (loop.ticks != expected || loop.droppedTicks != 0) {
+        printf("  FAIL: %ld ticks for %ld expected (%ld dropped)\n", loop.ticks, expected, loop.droppedTicks);
+        ok = false;
+    }
+    char stats[160];
+    FormatLoopStats(&loop, stats, sizeof(stats));
+    printf("loop: %ld frames, %.1f ns per AdvanceFixedLoop\n", frames, elapsed / frames);
+    printf("  jittery 144 Hz display: %s\n", stats);
+
+    // A long stall must be capped instead of spiralling
+    InitFixedLoop(&loop, 60, DEFAULT_MAX_CATCH_UP);
+    AdvanceFixedLoop(&loop, 0);
+    int ticks = AdvanceFixedLoop(&loop, NS_PER_SECOND / 2);
+    if (ticks != DEFAULT_MAX_CATCH_UP || loop.droppedTicks != 30 - DEFAULT_MAX_CATCH_UP) {
+        printf("  FAIL: 500 ms stall ran %d ticks, dropped %ld\n", ticks, loop.droppedTicks);
+        ok = false;
+    }
+    printf("  500 ms stall: %d catch-up ticks, %ld dropped\n", ticks, loop.droppedTicks);
+
+    // Sim rate is independent of display rate: 240 Hz sim on a 60 Hz display
+    InitFixedLoop(&loop, 240, DEFAULT_MAX_CATCH_UP);
+    now = 0;
+    AdvanceFixedLoop(&loop, now);
+    for (int i = 0; i < 600; i++) {
+        now += NS_PER_SECOND / 60;
+        AdvanceFixedLoop(&loop, now);
+        double alpha = FixedLoopAlpha(&loop);
+        if (alpha < 0.0 || alpha >= 1.0) {
+            printf("  FAIL: interpolation factor %f out of range\n", alpha);
+            ok = false;
+            break;
+        }
+    }
+    if (loop.ticks != (long)(now / loop.tickNs)) {
+        printf("  FAIL: 240 Hz sim ran %ld ticks in 10 s\n", loop.ticks);
+        ok = false;
+    }
+    printf("  240 Hz sim on 60 Hz display: %ld ticks in 10 s\n", loop.ticks);
+
+    // Same number of ticks means the same game, whatever the frame timing was
+    static Game steady, jittery;
+    if (!CreateClassicGame(&steady) || !CreateClassicGame(&jittery)) {
+        return false;
+    }
+    SeedGame(&steady, 7);
+    InitializeGame(&steady);
+    for (long tick = 0; tick < 3600; tick++) {
+        QueueScriptedInputs(&steady);
+        UpdateGame(&steady);
+    }
+    SeedGame(&jittery, 7);
+    InitializeGame(&jittery);
+    InitFixedLoop(&loop, 60, DEFAULT_MAX_CATCH_UP);
+    now = 0;
+    AdvanceFixedLoop(&loop, now);
+    long simulated = 0;
+    while (simulated < 3600) {
+        now += frameNs + FakeJitterNs(frameNs / 2);
+        int due = AdvanceFixedLoop(&loop, now);
+        for (int i = 0; i < due && simulated < 3600; i++, simulated++) {
+            QueueScriptedInputs(&jittery);
+            UpdateGame(&jittery);
+        }
+    }
+    if (!SameGame(&steady, &jittery)) {
+        printf("  FAIL: frame jitter changed the simulation\n");
+        ok = false;
+    }
+    printf("  jittered frames reproduce the steady run: %s\n", ok ? "yes" : "no");
+
+    DestroyGame(&steady);
+    DestroyGame(&jittery);
+    return ok;
+}
+
+// Persistent back buffer versus allocating one every frame
+static bool BenchTarget(long frames) {
+    bool ok = true;
+    RenderTarget target;
+    InitRenderTarget(&target, &memoryRenderTarget, NULL);
+
+    // Steady state: only the first frame may allocate
+    long steadyAllocations = 0;
+    double start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        if (!BeginRenderFrame(&target, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+            printf("  FAIL: could not create the back buffer\n");
+            return false;
+        }
+        if (i > 0) {
+            steadyAllocations += target.frameAllocations;
+        }
+        ClearFramebuffer(&target.framebuffer, FB_RGB(0, 0, 0));
+    }
+    double persistent = (NowNs() - start) / frames;
+    if (steadyAllocations != 0 || target.allocations != 1) {
+        printf("  FAIL: %ld allocations in steady-state frames\n", steadyAllocations);
+        ok = false;
+    }
+
+    // Size changes rebuild the surface exactly once
+    BeginRenderFrame(&target, 1024, 768);
+    long resizeAllocations = target.frameAllocations;
+    BeginRenderFrame(&target, 1024, 768);
+    if (resizeAllocations != 1 || target.frameAllocations != 0) {
+        printf("  FAIL: resize made %ld allocations, next frame %ld\n", resizeAllocations, target.frameAllocations);
+        ok = false;
+    }
+    ReleaseRenderTarget(&target);
+
+    // What RenderGame used to do: a new buffer every frame
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        Framebuffer fb;
+        if (!CreateFramebuffer(&fb, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+            return false;
+        }
+        ClearFramebuffer(&fb, FB_RGB(0, 0, 0));
+        DestroyFramebuffer(&fb);
+    }
+    double perFrame = (NowNs() - start) / frames;
+
+    printf("target: %ld frames at %dx%d\n", frames, WINDOW_WIDTH, WINDOW_HEIGHT);
+    printf("  persistent:         %.1f us/frame, %ld allocations after the first frame\n", persistent / 1e3, steadyAllocations);
+    printf("  allocate per frame: %.1f us/frame\n", perFrame / 1e3);
+    return ok;
+}
+
+// Background drawn from scratch every frame versus blitting the baked layer
+// (the GDI path) versus drawing the dots straight into the frame (software)
+static bool BenchBackground(long frames) {
+    bool ok = true;
+    static Background background;
+    Framebuffer layer, frame;
+    if (!CreateFramebuffer(&layer, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateFramebuffer(&frame, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return false;
+    }
+
+    GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+    ClearFramebuffer(&layer, FB_RGB(0, 0, 0));
+    DrawBackgroundDots(&background, &layer);
+
+    // Old path: regenerate and draw every dot each frame
+    double start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+        ClearFramebuffer(&frame, FB_RGB(0, 0, 0));
+        DrawBackgroundDots(&background, &frame);
+    }
+    double perFrameDraw = (NowNs() - start) / frames;
+
+    // The baked layer must look exactly like drawing from scratch
+    Framebuffer blitted;
+    if (!CreateFramebuffer(&blitted, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return false;
+    }
+    BlitBackground(&blitted, &layer, 0);
+    if (memcmp(blitted.pixels, frame.pixels, (size_t)WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(uint32_t)) != 0) {
+        printf("  FAIL: baked layer differs from the drawn background\n");
+        ok = false;
+    }
+    DestroyFramebuffer(&blitted);
+
+    // New path: one blit, optionally scrolled
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        BlitBackground(&frame, &layer, 0);
+    }
+    double perFrameBlit = (NowNs() - start) / frames;
+
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        BlitBackground(&frame, &layer, (int)i);
+    }
+    double perFrameScroll = (NowNs() - start) / frames;
+
+    // Direct drawing must match the blit at every offset, the wrap included
+    Framebuffer drawn;
+    if (!CreateFramebuffer(&drawn, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return false;
+    }
+    const int scrolls[] = {0, 1, 37, WINDOW_HEIGHT / 2, WINDOW_HEIGHT - 1, WINDOW_HEIGHT, -5};
+    for (int i = 0; i < (int)(sizeof(scrolls) / sizeof(scrolls[0])); i++) {
+        BlitBackground(&frame, &layer, scrolls[i]);
+        DrawScrolledBackground(&background, &drawn, scrolls[i]);
+        if (memcmp(drawn.pixels, frame.pixels, (size_t)WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(uint32_t)) != 0) {
+            printf("  FAIL: direct background differs from the blit at scroll %d\n", scrolls[i]);
+            ok = false;
+        }
+    }
+    DestroyFramebuffer(&drawn);
+
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        DrawScrolledBackground(&background, &frame, 0);
+    }
+    double perFrameDirect = (NowNs() - start) / frames;
+
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        DrawScrolledBackground(&background, &frame, (int)i);
+    }
+    double perFrameDirectScroll = (NowNs() - start) / frames;
+
+    // The two passes of the direct draw on their own
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        DrawScrolledStars(&background, &frame, 0);
+    }
+    double perFrameStars = (NowNs() - start) / frames;
+
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        DrawScrolledNebulae(&background, &frame, 0);
+    }
+    double perFrameNebulae = (NowNs() - start) / frames;
+
+    printf("background: %ld frames, %d dots\n", frames, background.dotCount);
+    printf("  draw every frame: %.1f us/frame\n", perFrameDraw / 1e3);
+    printf("  baked blit:       %.1f us/frame\n", perFrameBlit / 1e3);
+    printf("  scrolled blit:    %.1f us/frame\n", perFrameScroll / 1e3);
+    printf("  direct draw:      %.1f us/frame\n", perFrameDirect / 1e3);
+    printf("  scrolled direct:  %.1f us/frame\n", perFrameDirectScroll / 1e3);
+    printf("  clear and stars:  %.1f us/frame (%d dots)\n", perFrameStars / 1e3, background.starCount);
+    printf("  nebulae:          %.1f us/frame (%d dots)\n", perFrameNebulae / 1e3,
+           background.dotCount - background.starCount);
+
+    DestroyFramebuffer(&layer);
+    DestroyFramebuffer(&frame);
+    return ok;
+}
+
+// Draw the ships and explosions of a game, either shape by shape as the GDI
+// code used to or from the atlas when one is given
+static void DrawSceneSprites(Framebuffer* fb, const Game* game, const SpriteAtlas* atlas) {
+    static ShapeList list;
+
+    const Formation* formation = &game->formation;
+    for (int row = 0; row < formation->rows; row++) {
+        for (int col = 0; col < formation->cols; col++) {
+            if (!IsAlienAlive(formation, row, col)) {
+                continue;
+            }
+            int type = formation->rowType[row];
+            int x = AlienX(formation, col);
+            int y = AlienY(formation, row);
+            if (atlas != NULL) {
+                BlitSprite(fb, atlas, SPRITE_ALIEN_0 + type, x, y);
+            } else {
+                list.count = 0;
+                BuildAlienShapes(&list, type, x, y);
+                DrawShapes(fb, &list, 0);
+            }
+        }
+    }
+
+    if (atlas != NULL) {
+        BlitSprite(fb, atlas, SPRITE_PLAYER, game->playerX, game->playerY);
+    } else {
+        list.count = 0;
+        BuildPlayerShapes(&list, game->playerX, game->playerY);
+        DrawShapes(fb, &list, 0);
+    }
+
+    for (int i = 0; i < game->explosionPool.count; i++) {
+        const Explosion* explosion = &game->explosions[i];
+        if (atlas != NULL) {
+            BlitSprite(fb, atlas, SPRITE_EXPLOSION_0 + explosion->frame, explosion->x, explosion->y);
+        } else {
+            list.count = 0;
+            BuildExplosionShapes(&list, explosion->frame, explosion->x, explosion->y);
+            DrawShapes(fb, &list, 0);
+        }
+    }
+}
+
+// Per-entity shape drawing versus blitting pre-rasterized sprites
+static bool BenchSprites(long frames) {
+    bool ok = true;
+    static Game game;
+    static Background background;
+    SpriteAtlas atlas;
+    Framebuffer layer, direct, blitted;
+    if (!BuildSpriteAtlas(&atlas) ||
+        !CreateFramebuffer(&layer, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateFramebuffer(&direct, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateFramebuffer(&blitted, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateClassicGame(&game)) {
+        return false;
+    }
+    GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+    ClearFramebuffer(&layer, FB_RGB(0, 0, 0));
+    DrawBackgroundDots(&background, &layer);
+
+    // Golden check: frames of a scripted game must come out pixel-identical
+    SeedGame(&game, 7);
+    InitializeGame(&game);
+    int compared = 0;
+    int explosionFrames = 0;
+    for (int tick = 0; tick < 20000 && ok; tick++) {
+        QueueScriptedInputs(&game);
+        UpdateGame(&game);
+        if (tick % 37 != 0 || game.state != GAME_PLAYING) {
+            continue;
+        }
+        BlitBackground(&direct, &layer, 0);
+        DrawSceneSprites(&direct, &game, NULL);
+        BlitBackground(&blitted, &layer, 0);
+        DrawSceneSprites(&blitted, &game, &atlas);
+        if (memcmp(direct.pixels, blitted.pixels, (size_t)WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(uint32_t)) != 0) {
+            printf("  FAIL: atlas frame differs from shape drawing at tick %u\n", game.tick);
+            ok = false;
+        }
+        explosionFrames += game.explosionPool.count > 0;
+        compared++;
+    }
+    if (explosionFrames == 0) {
+        printf("  FAIL: no explosion was compared\n");
+        ok = false;
+    }
+
+    // Frame cost as the formation thins out
+    printf("sprites: %ld frames per point, %d golden frames compared (%d with explosions)\n",
+           frames, compared, explosionFrames);
+    printf("  %-6s %14s %14s\n", "aliens", "shapes us/f", "atlas us/f");
+    static const int liveCounts[] = {ALIEN_ROWS * ALIEN_COLS, 27, 11, 0};
+    for (int c = 0; c < (int)(sizeof(liveCounts) / sizeof(liveCounts[0])); c++) {
+        SeedGame(&game, 7);
+        InitializeGame(&game);
+        game.state = GAME_PLAYING;
+        int killed = ALIEN_ROWS * ALIEN_COLS - liveCounts[c];
+        for (int i = 0; i < killed; i++) {
+            KillAlien(&game.formation, i % ALIEN_ROWS, i / ALIEN_ROWS);
+        }
+
+        // Only the sprites are timed, drawing over the last frame is fine
+        double start = NowNs();
+        for (long i = 0; i < frames; i++) {
+            DrawSceneSprites(&direct, &game, NULL);
+        }
+        double perFrameShapes = (NowNs() - start) / frames;
+
+        start = NowNs();
+        for (long i = 0; i < frames; i++) {
+            DrawSceneSprites(&blitted, &game, &atlas);
+        }
+        double perFrameAtlas = (NowNs() - start) / frames;
+
+        printf("  %-6d %14.1f %14.1f\n", liveCounts[c], perFrameShapes / 1e3, perFrameAtlas / 1e3);
+    }
+
+    FreeSpriteAtlas(&atlas);
+    DestroyFramebuffer(&layer);
+    DestroyFramebuffer(&direct);
+    DestroyFramebuffer(&blitted);
+    DestroyGame(&game);
+    return ok;
+}
+
+// Explosion shapes as they were built before the particle table, with cos
+// and sin per particle, kept as the reference the table must reproduce
+static void TrigExplosionShapes(ShapeList* list, int frame, int x, int y) {
+    static const uint32_t colors[] = {
+        FB_RGB(255, 255, 100), FB_RGB(255, 150, 50), FB_RGB(255, 50, 50), FB_RGB(200, 50, 50)
+    };
+    const uint32_t outline = FB_RGB(255, 100, 100);
+
+    uint32_t color = colors[frame % 4];
+    int size = 20 - frame * 2;
+    if (size < 5) size = 5;
+
+    int particles = 8 + frame * 2;
+    float angleStep = 2 * 3.14159f / particles;
+    int distance = 5 + frame * 2;
+
+    for (int j = 0; j < particles && list->count < SHAPE_LIST_CAPACITY; j++) {
+        float angle = j * angleStep;
+        int particleX = x + (int)(cos(angle) * distance);
+        int particleY = y + (int)(sin(angle) * distance);
+        Shape* shape = &list->shapes[list->count++];
+        shape->kind = SHAPE_ELLIPSE;
+        shape->fill = color;
+        shape->pen = outline;
+        shape->coords[0] = particleX - size/2;
+        shape->coords[1] = particleY - size/2;
+        shape->coords[2] = particleX + size/2;
+        shape->coords[3] = particleY + size/2;
+    }
+
+    if (frame < 4 && list->count < SHAPE_LIST_CAPACITY) {
+        Shape* shape = &list->shapes[list->count++];
+        shape->kind = SHAPE_ELLIPSE;
+        shape->fill = FB_RGB(255, 255, 255);
+        shape->pen = outline;
+        shape->coords[0] = x - 5;
+        shape->coords[1] = y - 5;
+        shape->coords[2] = x + 5;
+        shape->coords[3] = y + 5;
+    }
+}
+
+// Explosion drawing strategies, from per-particle trigonometry to atlas
+// blits grouped by frame
+typedef enum {
+    EXPLOSIONS_TRIG,
+    EXPLOSIONS_TABLE,
+    EXPLOSIONS_ATLAS,
+    EXPLOSIONS_BATCHED,
+    EXPLOSIONS_METHOD_COUNT
+} ExplosionMethod;
+
+// Draw explosions with one of the strategies. Shapes are drawn frame by
+// frame like the batched blits, so every method paints the same pixels.
+static void DrawExplosionsWith(Framebuffer* fb, const SpriteAtlas* atlas, const Explosion* explosions,
+                               int count, ExplosionMethod method) {
+    static ShapeList list;
+
+    if (method == EXPLOSIONS_BATCHED) {
+        BlitExplosions(fb, atlas, explosions, count);
+        return;
+    }
+    for (int frame = 0; frame < EXPLOSION_FRAMES; frame++) {
+        for (int i = 0; i < count; i++) {
+            const Explosion* explosion = &explosions[i];
+            if (explosion->frame != frame) {
+                continue;
+            }
+            if (method == EXPLOSIONS_ATLAS) {
+                BlitSprite(fb, atlas, SPRITE_EXPLOSION_0 + frame, explosion->x, explosion->y);
+                continue;
+            }
+            list.count = 0;
+            if (method == EXPLOSIONS_TRIG) {
+                TrigExplosionShapes(&list, frame, explosion->x, explosion->y);
+            } else {
+                BuildExplosionShapes(&list, frame, explosion->x, explosion->y);
+            }
+            DrawShapes(fb, &list, 0);
+        }
+    }
+}
+
+// Hundreds of simultaneous explosions: trigonometry per particle, the
+// particle table, atlas blits and atlas blits grouped by frame
+static bool BenchExplosions(long frames) {
+    bool ok = true;
+    enum { MAX_COUNT = 1000 };
+    static Explosion explosions[MAX_COUNT];
+    static const char* names[EXPLOSIONS_METHOD_COUNT] = {"trig", "table", "atlas", "batched"};
+    SpriteAtlas atlas;
+    Framebuffer reference, drawn;
+    if (!BuildSpriteAtlas(&atlas) ||
+        !CreateFramebuffer(&reference, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateFramebuffer(&drawn, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return false;
+    }
+
+    // Random explosions in every frame, some hanging over the edges
+    Rng rng;
+    SeedRandom(&rng, 23, 5);
+    for (int i = 0; i < MAX_COUNT; i++) {
+        explosions[i].x = RandomRange(&rng, WINDOW_WIDTH + 40) - 20;
+        explosions[i].y = RandomRange(&rng, WINDOW_HEIGHT + 40) - 20;
+        explosions[i].frame = RandomRange(&rng, EXPLOSION_FRAMES);
+        explosions[i].timer = 0;
+        explosions[i].active = true;
+    }
+
+    // Golden check: every method paints what the trigonometry painted
+    static const int counts[] = {100, 300, MAX_COUNT};
+    size_t bytes = (size_t)WINDOW_WIDTH * WINDOW_HEIGHT * sizeof(uint32_t);
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        ClearFramebuffer(&reference, FB_RGB(0, 0, 0));
+        DrawExplosionsWith(&reference, &atlas, explosions, counts[c], EXPLOSIONS_TRIG);
+        for (int m = EXPLOSIONS_TABLE; m < EXPLOSIONS_METHOD_COUNT; m++) {
+            ClearFramebuffer(&drawn, FB_RGB(0, 0, 0));
+            DrawExplosionsWith(&drawn, &atlas, explosions, counts[c], (ExplosionMethod)m);
+            if (memcmp(reference.pixels, drawn.pixels, bytes) != 0) {
+                printf("  FAIL: %s explosions differ from trig with %d explosions\n", names[m], counts[c]);
+                ok = false;
+            }
+        }
+    }
+
+    printf("explosions: %ld frames per point\n", frames);
+    printf("  %-10s %12s %12s %12s %12s\n", "explosions", "trig us/f", "table us/f", "atlas us/f", "batched us/f");
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        double perFrame[EXPLOSIONS_METHOD_COUNT];
+        for (int m = 0; m < EXPLOSIONS_METHOD_COUNT; m++) {
+            double start = NowNs();
+            for (long i = 0; i < frames; i++) {
+                DrawExplosionsWith(&drawn, &atlas, explosions, counts[c], (ExplosionMethod)m);
+            }
+            perFrame[m] = (NowNs() - start) / frames;
+        }
+        printf("  %-10d %12.1f %12.1f %12.1f %12.1f\n", counts[c],
+               perFrame[EXPLOSIONS_TRIG] / 1e3, perFrame[EXPLOSIONS_TABLE] / 1e3,
+               perFrame[EXPLOSIONS_ATLAS] / 1e3, perFrame[EXPLOSIONS_BATCHED] / 1e3);
+    }
+
+    FreeSpriteAtlas(&atlas);
+    DestroyFramebuffer(&reference);
+    DestroyFramebuffer(&drawn);
+    return ok;
+}
+
+// Two games with the same seed and inputs must stay bit-identical
+static bool BenchLockstep(long ticks) {
+    bool ok = true;
+    static Game first, second, reseeded;
+    if (!CreateClassicGame(&first) || !CreateClassicGame(&second) || !CreateClassicGame(&reseeded)) {
+        return false;
+    }
+    SeedGame(&first, 2024);
+    SeedGame(&second, 2024);
+    SeedGame(&reseeded, 2025);
+    InitializeGame(&first);
+    InitializeGame(&second);
+    InitializeGame(&reseeded);
+
+    long diverged = -1;
+    bool seedsDiffer = false;
+    for (long tick = 0; tick < ticks; tick++) {
+        QueueScriptedInputs(&first);
+        QueueScriptedInputs(&second);
+        QueueScriptedInputs(&reseeded);
+        UpdateGame(&first);
+        UpdateGame(&second);
+        UpdateGame(&reseeded);
+        if (!SameGame(&first, &second)) {
+            diverged = tick;
+            break;
+        }
+        if (HashGame(&first) != HashGame(&reseeded)) {
+            seedsDiffer = true;
+        }
+    }
+    if (diverged >= 0) {
+        printf("  FAIL: same seed diverged at tick %ld\n", diverged);
+        ok = false;
+    }
+    if (!seedsDiffer) {
+        printf("  FAIL: a different seed produced the same game\n");
+        ok = false;
+    }
+
+    // Generator cost against the CRT
+    Rng rng;
+    SeedRandom(&rng, 1, 0);
+    uint32_t sink = 0;
+    double start = NowNs();
+    for (long i = 0; i < ticks; i++) {
+        sink += (uint32_t)RandomRange(&rng, ALIEN_COLS);
+    }
+    double pcg = (NowNs() - start) / ticks;
+    srand(1);
+    start = NowNs();
+    for (long i = 0; i < ticks; i++) {
+        sink += (uint32_t)(rand() % ALIEN_COLS);
+    }
+    double crt = (NowNs() - start) / ticks;
+
+    printf("lockstep: %ld ticks, two games with seed 2024 %s\n", ticks, diverged < 0 ? "identical" : "diverged");
+    printf("  seed 2025 %s\n", seedsDiffer ? "plays a different game" : "plays the same game");
+    printf("  RandomRange %.2f ns, rand() %.2f ns (sink %u)\n", pcg, crt, sink);
+    DestroyGame(&first);
+    DestroyGame(&second);
+    DestroyGame(&reseeded);
+    return ok;
+}
+
+// Record a scripted session, round-trip the log and replay it at full speed
+static bool BenchReplay(long ticks) {
+    bool ok = true;
+    static Game live, replayed;
+    InputLog log, decoded;
+
+    if (!CreateClassicGame(&live) || !CreateClassicGame(&replayed)) {
+        return false;
+    }
+    SeedGame(&live, 99);
+    InitializeGame(&live);
+    InitInputLog(&log, live.seed);
+    for (long tick = 0; tick < ticks; tick++) {
+        GameInput inputs[MAX_PENDING_INPUTS];
+        int count = ScriptedInputs(&live, inputs);
+        for (int i = 0; i < count; i++) {
+            if (QueueInput(&live, inputs[i])) {
+                RecordInput(&log, live.tick, inputs[i]);
+            }
+        }
+        UpdateGame(&live);
+    }
+    log.endTick = live.tick;
+
+    size_t size = EncodedInputLogSize(&log);
+    uint8_t* buffer = malloc(size);
+    if (buffer == NULL || EncodeInputLog(&log, buffer, size) != size || !DecodeInputLog(&decoded, buffer, size)) {
+        printf("  FAIL: input log did not survive encoding\n");
+        free(buffer);
+        FreeInputLog(&log);
+        return false;
+    }
+
+    SeedGame(&replayed, decoded.seed);
+    InitializeGame(&replayed);
+    ReplayCursor cursor;
+    StartReplay(&cursor, &decoded);
+    double start = NowNs();
+    while (QueueReplayInputs(&cursor, &replayed)) {
+        UpdateGame(&replayed);
+    }
+    double elapsed = NowNs() - start;
+
+    if (HashGame(&replayed) != HashGame(&live)) {
+        printf("  FAIL: replay ended in a different state (tick %u vs %u)\n", replayed.tick, live.tick);
+        ok = false;
+    }
+
+    double minutes = ticks / (60.0 * DEFAULT_TICK_RATE);
+    printf("replay: %ld ticks, %d inputs, %zu bytes (%.0f bytes per minute of play)\n",
+           ticks, log.count, size, size / minutes);
+    printf("  %.0f ticks/s (%.0fx real time), final state %s\n",
+           ticks / (elapsed / 1e9), ticks / (elapsed / 1e9) / DEFAULT_TICK_RATE,
+           ok ? "identical" : "different");
+
+    free(buffer);
+    FreeInputLog(&log);
+    FreeInputLog(&decoded);
+    DestroyGame(&live);
+    DestroyGame(&replayed);
+    return ok;
+}
+
+// The formation as it used to be stored: one record per alien
+typedef struct {
+    int x, y;
+    bool alive;
+} ReferenceAlien;
+
+static ReferenceAlien referenceAliens[FORMATION_MAX_ROWS * FORMATION_MAX_COLS];
+
+// Old MoveAliens: scan for the edge, then rewrite every live position
+static void ReferenceMoveAliens(int rows, int cols, Direction* direction) {
+    bool reverse = false;
+    for (int i = 0; i < rows * cols && !reverse; i++) {
+        const ReferenceAlien* alien = &referenceAliens[i];
+        if (alien->alive) {
+            reverse = *direction == DIR_RIGHT ? alien->x + ALIEN_WIDTH + ALIEN_MOVE_SPEED > WINDOW_WIDTH
+                                              : alien->x - ALIEN_MOVE_SPEED < 0;
+        }
+    }
+    if (reverse) {
+        *direction = *direction == DIR_RIGHT ? DIR_LEFT : DIR_RIGHT;
+        return;
+    }
+    int moveAmount = *direction == DIR_RIGHT ? ALIEN_MOVE_SPEED : -ALIEN_MOVE_SPEED;
+    for (int i = 0; i < rows * cols; i++) {
+        if (referenceAliens[i].alive) {
+            referenceAliens[i].x += moveAmount;
+        }
+    }
+}
+
+// Old bullet test: every alien against the point
+static int ReferenceFindAlienAt(int rows, int cols, int x, int y) {
+    for (int i = 0; i < rows * cols; i++) {
+        const ReferenceAlien* alien = &referenceAliens[i];
+        if (alien->alive &&
+            x >= alien->x && x <= alien->x + ALIEN_WIDTH &&
+            y >= alien->y && y <= alien->y + ALIEN_HEIGHT) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The point test the game ran on the bitmask before bullets were swept:
+// first live alien, in row-major order, whose box (edges included) contains
+// the point. Only the rows and columns that can overlap the point are tested.
+static bool PointFindAlienAt(const Formation* formation, int x, int y, int* hitRow, int* hitCol) {
+    int firstRow, lastRow, firstCol, lastCol;
+    FormationCellRange(formation, x, y, x, y, &firstRow, &lastRow, &firstCol, &lastCol);
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            if (IsAlienAlive(formation, row, col)) {
+                *hitRow = row;
+                *hitCol = col;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Formation movement and hit tests, per-alien records versus origin + bitmask
+static bool BenchFormation(long steps) {
+    bool ok = true;
+    static Game game;
+    static const int sizes[][2] = {{ALIEN_ROWS, ALIEN_COLS}, {20, 40}, {100, 100}};
+    if (!CreateClassicGame(&game)) {
+        return false;
+    }
+
+    printf("formation: %ld moves and hit tests per size, half the aliens killed\n", steps);
+    printf("  %-8s %14s %14s %14s %14s %8s\n", "size", "old move ns", "new move ns", "old hit ns", "new hit ns", "hits");
+    for (int s = 0; s < 3; s++) {
+        int rows = sizes[s][0];
+        int cols = sizes[s][1];
+
+        // Squeeze big formations into the window; no drop so the run never ends
+        int pitchX = (WINDOW_WIDTH - 200) / cols;
+        int pitchY = (WINDOW_HEIGHT - 300) / rows;
+        if (pitchX > ALIEN_WIDTH + ALIEN_SPACING_H) pitchX = ALIEN_WIDTH + ALIEN_SPACING_H;
+        if (pitchY > ALIEN_HEIGHT + ALIEN_SPACING_V) pitchY = ALIEN_HEIGHT + ALIEN_SPACING_V;
+
+        SeedGame(&game, 3);
+        InitializeGame(&game);
+        game.state = GAME_PLAYING;
+        game.alienDropDistance = 0;
+        Formation* formation = &game.formation;
+        InitFormation(formation, rows, cols, 100, 80, pitchX, pitchY, ALIEN_WIDTH, ALIEN_HEIGHT);
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                ReferenceAlien* alien = &referenceAliens[row * cols + col];
+                alien->x = AlienX(formation, col);
+                alien->y = AlienY(formation, row);
+                alien->alive = true;
+            }
+        }
+
+        // Kill a random half, in both representations
+        Rng rng;
+        SeedRandom(&rng, 99, 1);
+        while (formation->liveCount > rows * cols / 2) {
+            int row = RandomRange(&rng, rows);
+            int col = RandomRange(&rng, cols);
+            if (IsAlienAlive(formation, row, col)) {
+                KillAlien(formation, row, col);
+                referenceAliens[row * cols + col].alive = false;
+            }
+        }
+
+        Direction direction = game.alienDirection;
+        double start = NowNs();
+        for (long i = 0; i < steps; i++) {
+            ReferenceMoveAliens(rows, cols, &direction);
+        }
+        double oldMove = (NowNs() - start) / steps;
+
+        start = NowNs();
+        for (long i = 0; i < steps; i++) {
+            MoveAliens(&game);
+        }
+        double newMove = (NowNs() - start) / steps;
+
+        // Both must end up in the same place
+        if (direction != game.alienDirection || game.state != GAME_PLAYING) {
+            printf("  FAIL: %dx%d formation moved differently\n", rows, cols);
+            ok = false;
+        }
+        for (int row = 0; row < rows && ok; row++) {
+            for (int col = 0; col < cols; col++) {
+                const ReferenceAlien* alien = &referenceAliens[row * cols + col];
+                if (alien->alive && (alien->x != AlienX(formation, col) || alien->y != AlienY(formation, row))) {
+                    printf("  FAIL: %dx%d alien %d,%d at %d,%d instead of %d,%d\n", rows, cols, row, col,
+                           AlienX(formation, col), AlienY(formation, row), alien->x, alien->y);
+                    ok = false;
+                    break;
+                }
+            }
+        }
+
+        // Bullets anywhere around the formation, including exact edges
+        int spanX = cols * pitchX + ALIEN_WIDTH + 20;
+        int spanY = rows * pitchY + ALIEN_HEIGHT + 20;
+        long oldHits = 0, newHits = 0;
+        start = NowNs();
+        for (long i = 0; i < steps; i++) {
+            int x = formation->originX - 10 + RandomRange(&rng, spanX);
+            int y = formation->originY - 10 + RandomRange(&rng, spanY);
+            oldHits += ReferenceFindAlienAt(rows, cols, x, y) >= 0;
+        }
+        double oldHit = (NowNs() - start) / steps;
+
+        start = NowNs();
+        for (long i = 0; i < steps; i++) {
+            int x = formation->originX - 10 + RandomRange(&rng, spanX);
+            int y = formation->originY - 10 + RandomRange(&rng, spanY);
+            int row, col;
+            newHits += PointFindAlienAt(formation, x, y, &row, &col);
+        }
+        double newHit = (NowNs() - start) / steps;
+
+        for (long i = 0; i < 20000 && ok; i++) {
+            int x = formation->originX - 10 + RandomRange(&rng, spanX);
+            int y = formation->originY - 10 + RandomRange(&rng, spanY);
+            int row = -1, col = -1;
+            int expected = ReferenceFindAlienAt(rows, cols, x, y);
+            bool found = PointFindAlienAt(formation, x, y, &row, &col);
+            if (found != (expected >= 0) || (found && row * cols + col != expected)) {
+                printf("  FAIL: %dx%d hit test at %d,%d found %d,%d, expected index %d\n",
+                       rows, cols, x, y, row, col, expected);
+                ok = false;
+            }
+        }
+
+        char size[16];
+        snprintf(size, sizeof(size), "%dx%d", rows, cols);
+        printf("  %-8s %14.1f %14.1f %14.1f %14.1f %7.1f%%\n", size, oldMove, newMove, oldHit, newHit,
+               50.0 * (oldHits + newHits) / steps);
+    }
+    DestroyGame(&game);
+    return ok;
+}
+
+// Shield blocks as they used to be stored: position and flag per block
+typedef struct {
+    int x, y;
+    bool active;
+} ReferenceShieldBlock;
+
+typedef struct {
+    int x, y;
+    ReferenceShieldBlock blocks[SHIELD_COLS][SHIELD_ROWS];
+} ReferenceShield;
+
+// Old bullet-vs-shield loop; its break only leaves the row loop
+static bool ReferenceHitShield(ReferenceShield* shield, int bulletX, int bulletY) {
+    bool hit = false;
+    for (int x = 0; x < SHIELD_COLS; x++) {
+        for (int y = 0; y < SHIELD_ROWS; y++) {
+            ReferenceShieldBlock* block = &shield->blocks[x][y];
+            if (block->active &&
+                bulletX >= block->x && bulletX <= block->x + SHIELD_BLOCK_SIZE &&
+                bulletY >= block->y && bulletY <= block->y + SHIELD_BLOCK_SIZE) {
+                block->active = false;
+                hit = true;
+                break;
+            }
+        }
+    }
+    return hit;
+}
+
+// The bitmap point test the game ran before bullets were swept: knock out
+// the shield blocks a bullet at x, y touches. Blocks include their right and
+// bottom edges, so a point on a block boundary touches two columns (and two
+// rows). Each touched column loses its topmost active touched block, which
+// is what the original per-block scan did.
+static bool PointHitShield(Shield* shield, int x, int y) {
+    int localX = x - shield->x;
+    int localY = y - shield->y;
+    if (localX < 0 || localX > SHIELD_WIDTH || localY < 0 || localY > SHIELD_HEIGHT) {
+        return false;
+    }
+
+    // Touched columns as a mask, touched rows from top to bottom
+    int col = localX / SHIELD_BLOCK_SIZE;
+    int row = localY / SHIELD_BLOCK_SIZE;
+    unsigned columns = (col < SHIELD_COLS ? 1u << col : 0) |
+                       (localX % SHIELD_BLOCK_SIZE == 0 && col > 0 ? 1u << (col - 1) : 0);
+    int firstRow = localY % SHIELD_BLOCK_SIZE == 0 && row > 0 ? row - 1 : row;
+    int lastRow = row < SHIELD_ROWS ? row : SHIELD_ROWS - 1;
+
+    bool hit = false;
+    for (int r = firstRow; r <= lastRow && columns != 0; r++) {
+        unsigned struck = shield->rows[r] & columns;
+        if (struck != 0) {
+            shield->rows[r] &= (uint16_t)~struck;
+            columns &= ~struck;
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+static void CopyToReferenceShield(const Shield* shield, ReferenceShield* reference) {
+    reference->x = shield->x;
+    reference->y = shield->y;
+    for (int x = 0; x < SHIELD_COLS; x++) {
+        for (int y = 0; y < SHIELD_ROWS; y++) {
+            reference->blocks[x][y].x = shield->x + x * SHIELD_BLOCK_SIZE;
+            reference->blocks[x][y].y = shield->y + y * SHIELD_BLOCK_SIZE;
+            reference->blocks[x][y].active = IsShieldBlockActive(shield, x, y);
+        }
+    }
+}
+
+static bool SameShield(const Shield* shield, const ReferenceShield* reference) {
+    for (int x = 0; x < SHIELD_COLS; x++) {
+        for (int y = 0; y < SHIELD_ROWS; y++) {
+            if (IsShieldBlockActive(shield, x, y) != reference->blocks[x][y].active) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Bullet-vs-shield tests, per-block records versus one bit per block
+static bool BenchShields(long bullets) {
+    bool ok = true;
+    static Game game;
+    static ReferenceShield reference[SHIELD_COUNT];
+    if (!CreateClassicGame(&game)) {
+        return false;
+    }
+    SeedGame(&game, 11);
+    InitializeGame(&game);
+    Rng rng;
+    SeedRandom(&rng, 11, 3);
+
+    // Bullets land anywhere around the shields, often right on block edges
+    int top = game.shields[0].y - 4;
+    int height = SHIELD_HEIGHT + 8;
+    int snapped = 0;
+
+    // Same damage in both layouts, shield after shield, checked after every bullet
+    for (int s = 0; s < SHIELD_COUNT; s++) {
+        CopyToReferenceShield(&game.shields[s], &reference[s]);
+    }
+    long hits = 0;
+    for (long i = 0; i < 200000 && ok; i++) {
+        int x = RandomRange(&rng, WINDOW_WIDTH);
+        int y = top + RandomRange(&rng, height);
+        if (i % 3 == 0) {
+            x -= x % SHIELD_BLOCK_SIZE;
+            y -= y % SHIELD_BLOCK_SIZE;
+            snapped++;
+        }
+        for (int s = 0; s < SHIELD_COUNT; s++) {
+            bool expected = ReferenceHitShield(&reference[s], x, y);
+            bool actual = PointHitShield(&game.shields[s], x, y);
+            hits += actual;
+            if (expected != actual || !SameShield(&game.shields[s], &reference[s])) {
+                printf("  FAIL: bullet at %d,%d hit shield %d differently\n", x, y, s);
+                ok = false;
+            }
+        }
+        if (i % 1000 == 999) {
+            InitializeShields(&game);
+            for (int s = 0; s < SHIELD_COUNT; s++) {
+                CopyToReferenceShield(&game.shields[s], &reference[s]);
+            }
+        }
+    }
+
+    // Cost of testing one bullet against every shield, on intact shields
+    InitializeShields(&game);
+    int* points = malloc(sizeof(int) * 2 * 4096);
+    if (points == NULL) {
+        return false;
+    }
+    for (int i = 0; i < 4096; i++) {
+        points[i * 2] = RandomRange(&rng, WINDOW_WIDTH);
+        points[i * 2 + 1] = top + RandomRange(&rng, height);
+    }
+
+    long checksum = 0;
+    double start = NowNs();
+    for (long i = 0; i < bullets; i++) {
+        if (i % 4096 == 0) {
+            for (int s = 0; s < SHIELD_COUNT; s++) {
+                CopyToReferenceShield(&game.shields[s], &reference[s]);
+            }
+        }
+        const int* point = &points[(i % 4096) * 2];
+        for (int s = 0; s < SHIELD_COUNT; s++) {
+            checksum += ReferenceHitShield(&reference[s], point[0], point[1]);
+        }
+    }
+    double oldNs = (NowNs() - start) / bullets;
+
+    start = NowNs();
+    for (long i = 0; i < bullets; i++) {
+        if (i % 4096 == 0) {
+            InitializeShields(&game);
+        }
+        const int* point = &points[(i % 4096) * 2];
+        for (int s = 0; s < SHIELD_COUNT; s++) {
+            checksum -= PointHitShield(&game.shields[s], point[0], point[1]);
+        }
+    }
+    double newNs = (NowNs() - start) / bullets;
+    free(points);
+    benchSink = checksum;
+
+    printf("shields: %ld bullets against %d shields, %ld hits checked (%d on block corners)\n",
+           bullets, SHIELD_COUNT, hits, snapped);
+    printf("  per-block records: %6.1f ns/bullet, %zu bytes per shield\n", oldNs, sizeof(ReferenceShield));
+    printf("  bitmap:            %6.1f ns/bullet, %zu bytes per shield\n", newNs, sizeof(Shield));
+    DestroyGame(&game);
+    return ok;
+}
+
+// Recompute the formation bookkeeping from the alive flags
+static bool CheckFormationIndex(const Formation* formation) {
+    int minCol = -1, maxCol = -1, lowestLiveRow = -1, liveColumns = 0;
+    for (int col = 0; col < formation->cols; col++) {
+        int count = 0, lowest = -1;
+        for (int row = 0; row < formation->rows; row++) {
+            if (IsAlienAlive(formation, row, col)) {
+                count++;
+                lowest = row;
+            }
+        }
+        if (count != formation->columnCount[col] || lowest != formation->lowestRow[col]) {
+            return false;
+        }
+        if (count > 0) {
+            if (minCol < 0) minCol = col;
+            maxCol = col;
+            if (lowest > lowestLiveRow) lowestLiveRow = lowest;
+            liveColumns++;
+            if (formation->liveColumns[formation->columnSlot[col]] != col) {
+                return false;
+            }
+        }
+    }
+    return minCol == formation->minCol && maxCol == formation->maxCol &&
+           lowestLiveRow == formation->lowestLiveRow && liveColumns == formation->liveColumnCount;
+}
+
+// Old shooter choice: up to 50 random cells, then down the column
+static bool ReferencePickShooter(const Formation* formation, Rng* rng, int* shooterRow, int* shooterCol) {
+    for (int attempts = 0; attempts < 50; attempts++) {
+        int row = RandomRange(rng, formation->rows);
+        int col = RandomRange(rng, formation->cols);
+        if (IsAlienAlive(formation, row, col)) {
+            int lowestRow = row;
+            for (int r = row + 1; r < formation->rows; r++) {
+                if (IsAlienAlive(formation, r, col)) {
+                    lowestRow = r;
+                }
+            }
+            *shooterRow = lowestRow;
+            *shooterCol = col;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Old edge search: scan every row from the right for its last live alien
+static int ReferenceMaxColumn(const Formation* formation) {
+    int maxCol = -1;
+    for (int row = 0; row < formation->rows; row++) {
+        for (int col = formation->cols - 1; col > maxCol; col--) {
+            if (IsAlienAlive(formation, row, col)) {
+                maxCol = col;
+                break;
+            }
+        }
+    }
+    return maxCol;
+}
+
+// Edge detection and shooter choice while the formation is shot down
+static bool BenchShooters(long iterations) {
+    bool ok = true;
+    static Formation formation;
+    static const int sizes[][2] = {{ALIEN_ROWS, ALIEN_COLS}, {100, 100}};
+
+    printf("shooters: %ld edge + shooter picks per point\n", iterations);
+    printf("  %-8s %6s %12s %12s %14s\n", "size", "live", "old ns", "new ns", "old misses");
+    for (int s = 0; s < 2; s++) {
+        int rows = sizes[s][0];
+        int cols = sizes[s][1];
+        int total = rows * cols;
+        int checkpoints[] = {total, total / 2, total / 10, 1};
+        InitFormation(&formation, rows, cols, 0, 0, ALIEN_WIDTH + ALIEN_SPACING_H,
+                      ALIEN_HEIGHT + ALIEN_SPACING_V, ALIEN_WIDTH, ALIEN_HEIGHT);
+
+        Rng rng;
+        SeedRandom(&rng, 5, 2);
+        for (int c = 0; c < 4; c++) {
+            // Shoot aliens down in random order, checking the bookkeeping on every kill
+            while (formation.liveCount > checkpoints[c]) {
+                int row = RandomRange(&rng, rows);
+                int col = RandomRange(&rng, cols);
+                if (IsAlienAlive(&formation, row, col)) {
+                    KillAlien(&formation, row, col);
+                    if (ok && !CheckFormationIndex(&formation)) {
+                        printf("  FAIL: %dx%d bookkeeping wrong after killing %d,%d\n", rows, cols, row, col);
+                        ok = false;
+                    }
+                }
+            }
+
+            long misses = 0;
+            long checksum = 0;
+            double start = NowNs();
+            for (long i = 0; i < iterations; i++) {
+                int row = -1, col = -1;
+                if (!ReferencePickShooter(&formation, &rng, &row, &col)) {
+                    misses++;
+                }
+                checksum += ReferenceMaxColumn(&formation) + row;
+            }
+            double oldNs = (NowNs() - start) / iterations;
+
+            start = NowNs();
+            for (long i = 0; i < iterations; i++) {
+                int col = formation.liveColumns[RandomRange(&rng, formation.liveColumnCount)];
+                int row = formation.lowestRow[col];
+                if (row < 0 || !IsAlienAlive(&formation, row, col)) {
+                    printf("  FAIL: %dx%d picked an empty shooter at %d,%d\n", rows, cols, row, col);
+                    ok = false;
+                    break;
+                }
+                checksum -= formation.maxCol + row;
+            }
+            double newNs = (NowNs() - start) / iterations;
+
+            char size[16];
+            snprintf(size, sizeof(size), "%dx%d", rows, cols);
+            printf("  %-8s %6d %12.1f %12.1f %13.1f%%\n", size, formation.liveCount, oldNs, newNs,
+                   100.0 * misses / iterations);
+            benchSink = checksum;
+        }
+    }
+    return ok;
+}
+
+// Brute-force swept collision passes: every bullet path against every
+// alien, the player and every shield block, with the same tie rules as
+// CollidePlayerBullets and CollideAlienBullets
+static int BruteForceSweepShields(const Game* game, const Bullet* bullet, uint16_t* struck, double* hitTime) {
+    int hitShield = -1;
+    for (int s = 0; s < game->config.shieldCount; s++) {
+        const Shield* shield = &game->shields[s];
+        for (int y = 0; y < SHIELD_ROWS; y++) {
+            for (int x = 0; x < SHIELD_COLS; x++) {
+                int blockX = shield->x + x * SHIELD_BLOCK_SIZE;
+                int blockY = shield->y + y * SHIELD_BLOCK_SIZE;
+                double time;
+                if (!IsShieldBlockActive(shield, x, y) ||
+                    !SweepBox(bullet->prevX, bullet->prevY, bullet->x, bullet->y,
+                              blockX, blockY, blockX + SHIELD_BLOCK_SIZE, blockY + SHIELD_BLOCK_SIZE, &time)) {
+                    continue;
+                }
+                if (hitShield < 0 || time < *hitTime) {
+                    memset(struck, 0, sizeof(uint16_t) * SHIELD_ROWS);
+                    hitShield = s;
+                    *hitTime = time;
+                }
+                if (hitShield == s && time == *hitTime) {
+                    struck[y] |= (uint16_t)(1u << x);
+                }
+            }
+        }
+    }
+    return hitShield;
+}
+
+static void BruteForceCollisions(Game* game, Bullet* playerBullets, int playerCount,
+                                 Bullet* alienBullets, int alienCount) {
+    Formation* formation = &game->formation;
+    for (int i = 0; i < playerCount; i++) {
+        Bullet* bullet = &playerBullets[i];
+        if (!bullet->active) {
+            continue;
+        }
+        int hitRow = -1, hitCol = -1;
+        double alienTime = 0.0;
+        for (int row = 0; row < formation->rows; row++) {
+            for (int col = 0; col < formation->cols; col++) {
+                int x = AlienX(formation, col);
+                int y = AlienY(formation, row);
+                double time;
+                if (IsAlienAlive(formation, row, col) &&
+                    SweepBox(bullet->prevX, bullet->prevY, bullet->x, bullet->y,
+                             x, y, x + formation->width, y + formation->height, &time) &&
+                    (hitRow < 0 || time < alienTime)) {
+                    hitRow = row;
+                    hitCol = col;
+                    alienTime = time;
+                }
+            }
+        }
+
+        uint16_t struck[SHIELD_ROWS];
+        double shieldTime = 0.0;
+        int shield = BruteForceSweepShields(game, bullet, struck, &shieldTime);
+        if (hitRow >= 0 && (shield < 0 || alienTime <= shieldTime)) {
+            KillAlien(formation, hitRow, hitCol);
+            bullet->active = false;
+            switch (formation->rowType[hitRow]) {
+                case 0: game->score += 30; break;
+                case 1: game->score += 20; break;
+                case 2: game->score += 10; break;
+            }
+            CreateExplosion(game, AlienX(formation, hitCol) + formation->width / 2,
+                            AlienY(formation, hitRow) + formation->height / 2);
+        } else if (shield >= 0) {
+            for (int y = 0; y < SHIELD_ROWS; y++) {
+                game->shields[shield].rows[y] &= (uint16_t)~struck[y];
+            }
+            bullet->active = false;
+        }
+    }
+
+    bool playerHit = false;
+    for (int i = 0; i < alienCount; i++) {
+        Bullet* bullet = &alienBullets[i];
+        if (!bullet->active) {
+            continue;
+        }
+        double playerTime = 0.0;
+        bool hitsPlayer = !playerHit &&
+                          SweepBox(bullet->prevX, bullet->prevY, bullet->x, bullet->y,
+                                   game->playerX, game->playerY,
+                                   game->playerX + PLAYER_WIDTH, game->playerY + PLAYER_HEIGHT, &playerTime);
+
+        uint16_t struck[SHIELD_ROWS];
+        double shieldTime = 0.0;
+        int shield = BruteForceSweepShields(game, bullet, struck, &shieldTime);
+        if (hitsPlayer && (shield < 0 || playerTime <= shieldTime)) {
+            bullet->active = false;
+            playerHit = true;
+            game->playerLives--;
+            CreateExplosion(game, game->playerX + PLAYER_WIDTH / 2, game->playerY + PLAYER_HEIGHT / 2);
+            if (game->playerLives <= 0) {
+                game->state = GAME_OVER;
+                game->gameOverTimer = 0;
+            }
+        } else if (shield >= 0) {
+            for (int y = 0; y < SHIELD_ROWS; y++) {
+                game->shields[shield].rows[y] &= (uint16_t)~struck[y];
+            }
+            bullet->active = false;
+        }
+    }
+}
+
+// The grid as BuildCollisionGrid used to make it every tick: cleared, then
+// every shield, the formation box and the player inserted again
+static void InsertGridBox(CollisionGrid* grid, int left, int top, int right, int bottom, unsigned target) {
+    int col0 = left < 0 ? 0 : left / GRID_CELL_SIZE;
+    int col1 = right < 0 ? 0 : right / GRID_CELL_SIZE;
+    int row0 = top < 0 ? 0 : top / GRID_CELL_SIZE;
+    int row1 = bottom < 0 ? 0 : bottom / GRID_CELL_SIZE;
+    if (col0 >= grid->cols) col0 = grid->cols - 1;
+    if (col1 >= grid->cols) col1 = grid->cols - 1;
+    if (row0 >= grid->rows) row0 = grid->rows - 1;
+    if (row1 >= grid->rows) row1 = grid->rows - 1;
+    for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+            grid->cells[(size_t)row * grid->cols + col] |= target;
+        }
+    }
+}
+
+static void RebuildCollisionGrid(CollisionGrid* grid, const Game* game) {
+    memset(grid->cells, 0, sizeof(uint32_t) * grid->cols * grid->rows);
+    for (int s = 0; s < game->config.shieldCount; s++) {
+        const Shield* shield = &game->shields[s];
+        InsertGridBox(grid, shield->x, shield->y, shield->x + SHIELD_WIDTH, shield->y + SHIELD_HEIGHT,
+                      GRID_TARGET_SHIELD(s));
+    }
+    const Formation* formation = &game->formation;
+    if (formation->liveCount > 0) {
+        InsertGridBox(grid, AlienX(formation, formation->minCol), AlienY(formation, 0),
+                      AlienX(formation, formation->maxCol) + formation->width,
+                      AlienY(formation, formation->lowestLiveRow) + formation->height,
+                      GRID_TARGET_FORMATION);
+    }
+    InsertGridBox(grid, game->playerX, game->playerY, game->playerX + PLAYER_WIDTH,
+                  game->playerY + PLAYER_HEIGHT, GRID_TARGET_PLAYER);
+}
+
+// Grid upkeep while a large formation marches and is shot down: the
+// in-place update against a rebuild every tick, which must give the same
+// cells
+static bool BenchGridUpkeep(Game* game, const Game* start, long ticks) {
+    bool ok = true;
+    CollisionGrid kept, rebuilt;
+    if (!CreateCollisionGrid(&kept, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateCollisionGrid(&rebuilt, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return false;
+    }
+    CopyGame(game, start);
+    game->alienMoveDelay = 2;
+
+    Rng rng;
+    SeedRandom(&rng, 13, 5);
+    double keptNs = 0, rebuiltNs = 0;
+    long played = 0, moves = 0, mismatches = 0;
+    for (; played < ticks && game->state == GAME_PLAYING; played++) {
+        Formation* formation = &game->formation;
+        int row = RandomRange(&rng, formation->rows);
+        int col = RandomRange(&rng, formation->cols);
+        if (IsAlienAlive(formation, row, col) && formation->liveCount > 1) {
+            KillAlien(formation, row, col);
+        }
+        int originX = AlienX(formation, 0), originY = AlienY(formation, 0);
+        UpdateGame(game);
+        moves += AlienX(formation, 0) != originX || AlienY(formation, 0) != originY;
+
+        double begin = NowNs();
+        BuildCollisionGrid(&kept, game);
+        keptNs += NowNs() - begin;
+        begin = NowNs();
+        RebuildCollisionGrid(&rebuilt, game);
+        rebuiltNs += NowNs() - begin;
+        mismatches += memcmp(kept.cells, rebuilt.cells, sizeof(uint32_t) * kept.cols * kept.rows) != 0;
+    }
+
+    printf("  grid upkeep over %ld ticks, %ld formation moves: %.1f ns/tick in place, %.1f ns/tick rebuilt\n",
+           played, moves, keptNs / played, rebuiltNs / played);
+    if (mismatches > 0) {
+        printf("  FAIL: the grid updated in place differs from a rebuild on %ld ticks\n", mismatches);
+        ok = false;
+    }
+    DestroyCollisionGrid(&kept);
+    DestroyCollisionGrid(&rebuilt);
+    return ok;
+}
+
+// Grid broadphase versus brute force from 10 to 100,000 bullets
+static bool BenchBroadphase(long maxBullets) {
+    bool ok = true;
+    static Game start, grid, brute;
+    int rows = 40, cols = 60;
+
+    if (!CreateClassicGame(&start) || !CreateClassicGame(&grid) || !CreateClassicGame(&brute)) {
+        return false;
+    }
+    SeedGame(&start, 13);
+    InitializeGame(&start);
+    start.state = GAME_PLAYING;
+    start.playerLives = 1000000;
+    InitFormation(&start.formation, rows, cols, 100, 60, (WINDOW_WIDTH - 200) / cols, (WINDOW_HEIGHT - 300) / rows,
+                  ALIEN_WIDTH, ALIEN_HEIGHT);
+
+    Bullet* initial = malloc(sizeof(Bullet) * maxBullets);
+    Bullet* gridBullets = malloc(sizeof(Bullet) * maxBullets);
+    Bullet* bruteBullets = malloc(sizeof(Bullet) * maxBullets);
+    if (initial == NULL || gridBullets == NULL || bruteBullets == NULL) {
+        return false;
+    }
+    Rng rng;
+    SeedRandom(&rng, 13, 4);
+    for (long i = 0; i < maxBullets; i++) {
+        initial[i].active = true;
+        initial[i].x = RandomRange(&rng, WINDOW_WIDTH + 1);
+        initial[i].y = RandomRange(&rng, WINDOW_HEIGHT + 1);
+        // A short path in any direction, so the sweep has something to do
+        initial[i].prevX = initial[i].x + RandomRange(&rng, 9) - 4;
+        initial[i].prevY = initial[i].y + RandomRange(&rng, 25) - 12;
+    }
+
+    printf("broadphase: one collision pass, %dx%d formation, half player and half alien bullets\n", rows, cols);
+    printf("  %-8s %14s %14s %10s\n", "bullets", "grid ns/b", "brute ns/b", "hits");
+    for (long count = 10; count <= maxBullets; count *= 10) {
+        int half = (int)(count / 2);
+        size_t bytes = sizeof(Bullet) * count;
+
+        // Brute force once, it is the reference
+        CopyGame(&brute, &start);
+        memcpy(bruteBullets, initial, bytes);
+        double begin = NowNs();
+        BruteForceCollisions(&brute, bruteBullets, half, bruteBullets + half, (int)count - half);
+        double bruteNs = (NowNs() - begin) / count;
+
+        // Grid, repeated so small counts still time something
+        long repeats = 100000 / count > 0 ? 100000 / count : 1;
+        double gridNs = 0;
+        for (long r = 0; r < repeats; r++) {
+            CopyGame(&grid, &start);
+            memcpy(gridBullets, initial, bytes);
+            begin = NowNs();
+            BuildCollisionGrid(grid.collisionGrid, &grid);
+            CollidePlayerBullets(&grid, grid.collisionGrid, gridBullets, half);
+            CollideAlienBullets(&grid, grid.collisionGrid, gridBullets + half, (int)count - half);
+            gridNs += NowNs() - begin;
+        }
+        gridNs /= (double)repeats * count;
+
+        long hits = 0;
+        for (long i = 0; i < count; i++) {
+            hits += !bruteBullets[i].active;
+        }
+        if (!SameGame(&grid, &brute) || memcmp(gridBullets, bruteBullets, bytes) != 0) {
+            printf("  FAIL: grid and brute force disagree with %ld bullets\n", count);
+            ok = false;
+        }
+        printf("  %-8ld %14.1f %14.1f %10ld\n", count, gridNs, bruteNs, hits);
+    }
+    ok = BenchGridUpkeep(&grid, &start, 2000) && ok;
+
+    free(initial);
+    free(gridBullets);
+    free(bruteBullets);
+    DestroyGame(&start);
+    DestroyGame(&grid);
+    DestroyGame(&brute);
+    return ok;
+}
+
+// Static targets for the sweep benchmark: the aliens neither move nor
+// shoot and the player cannot run out of lives
+static void SetUpSweepGame(Game* game, int stepTicks) {
+    SeedGame(game, 17);
+    InitializeGame(game);
+    game->state = GAME_PLAYING;
+    game->playerLives = 1000000;
+    game->alienMoveDelay = 1 << 30;
+    game->alienShootDelay = 1 << 30;
+    game->stepTicks = stepTicks;
+}
+
+// Run until every bullet is gone, returns the number of updates
+static long RunUntilBulletsGone(Game* game) {
+    long updates = 0;
+    while (game->playerBulletPool.count > 0 || game->alienBulletPool.count > 0) {
+        UpdateGame(game);
+        updates++;
+    }
+    return updates;
+}
+
+// Ticks a live game plays at every step size against single ticks
+#define SWEEP_LOCKSTEP_TICKS 6000
+
+// The classic game, the formation marching and firing and the scripted
+// player shooting back, updated step ticks at a time next to a game
+// updated one tick at a time with the same inputs at the start of each
+// step. Returns the tick at which the two first differ, -1 if never.
+static long FirstStepDivergence(Game* coarse, Game* fine, int step, long ticks) {
+    SeedGame(coarse, 23);
+    InitializeGame(coarse);
+    SeedGame(fine, 23);
+    InitializeGame(fine);
+    coarse->stepTicks = step;
+    while (coarse->tick < (uint32_t)ticks) {
+        GameInput inputs[MAX_PENDING_INPUTS];
+        int count = ScriptedInputs(coarse, inputs);
+        for (int i = 0; i < count; i++) {
+            QueueInput(coarse, inputs[i]);
+            QueueInput(fine, inputs[i]);
+        }
+        UpdateGame(coarse);
+        for (int t = 0; t < step; t++) {
+            UpdateGame(fine);
+        }
+        if (HashGame(coarse) != HashGame(fine)) {
+            return (long)fine->tick;
+        }
+    }
+    return -1;
+}
+
+// Swept collision at 1 to 16 ticks per update: bullets fired through intact
+// shields never tunnel, the same shots give the same game at every step,
+// and a live game plays out tick for tick as it does one tick at a time
+static bool BenchSweep(long trials) {
+    bool ok = true;
+    static const int steps[] = {1, 2, 4, 8, 16};
+    static Game game, fine;
+    Rng rng;
+    if (!CreateClassicGame(&game) || !CreateClassicGame(&fine)) {
+        return false;
+    }
+
+    printf("sweep: %ld shots per step size, player bullets at %d px and alien bullets at %d px per tick\n",
+           trials, PLAYER_BULLET_SPEED, ALIEN_BULLET_SPEED);
+    printf("  %-6s %14s %14s %14s\n", "step", "point misses", "swept misses", "ns/tick");
+    for (int k = 0; k < (int)(sizeof(steps) / sizeof(steps[0])); k++) {
+        int step = steps[k];
+
+        // Straight up through an intact shield. The point test is what the
+        // game did before: one PointHitShield at the end of every update.
+        SetUpSweepGame(&game, step);
+        SeedRandom(&rng, 17, 5);
+        long pointMisses = 0, sweptMisses = 0;
+        for (long i = 0; i < trials; i++) {
+            InitializeShields(&game);
+            const Shield* shield = &game.shields[RandomRange(&rng, SHIELD_COUNT)];
+            game.playerX = shield->x + RandomRange(&rng, SHIELD_WIDTH + 1) - PLAYER_WIDTH / 2;
+
+            Shield point = *shield;
+            bool pointHit = false;
+            for (int y = game.playerY - PLAYER_BULLET_SPEED * step; y >= 0 && !pointHit; y -= PLAYER_BULLET_SPEED * step) {
+                pointHit = PointHitShield(&point, game.playerX + PLAYER_WIDTH / 2, y);
+            }
+            pointMisses += !pointHit;
+
+            Shield intact = *shield;
+            FirePlayerBullet(&game);
+            RunUntilBulletsGone(&game);
+            sweptMisses += memcmp(&intact, shield, sizeof(Shield)) == 0;
+        }
+        if (sweptMisses != 0) {
+            printf("  FAIL: %ld bullets went through a shield at step %d\n", sweptMisses, step);
+            ok = false;
+        }
+
+        // Alternate player shots from anywhere and alien bullets dropped
+        // above the shields, replaying the same shots at every step size
+        SetUpSweepGame(&game, step);
+        SeedRandom(&rng, 17, 6);
+        long updates = 0;
+        double start = NowNs();
+        for (long i = 0; i < trials; i++) {
+            if (game.formation.liveCount < ALIEN_ROWS * ALIEN_COLS / 4) {
+                InitializeLevel(&game);
+                game.alienMoveDelay = 1 << 30;
+                game.alienShootDelay = 1 << 30;
+            }
+            if (i % 2 == 0) {
+                game.playerX = RandomRange(&rng, WINDOW_WIDTH - PLAYER_WIDTH + 1);
+                FirePlayerBullet(&game);
+            } else {
+                Bullet* bullet = &game.alienBullets[AcquireSlot(&game.alienBulletPool)];
+                bullet->active = true;
+                bullet->x = RandomRange(&rng, WINDOW_WIDTH + 1);
+                bullet->y = game.shields[0].y - 1 - RandomRange(&rng, 150);
+                bullet->prevX = bullet->x;
+                bullet->prevY = bullet->y;
+            }
+            updates += RunUntilBulletsGone(&game);
+        }
+        double ns = (NowNs() - start) / ((double)updates * step);
+
+        if (step == 1) {
+            CopyGame(&fine, &game);
+        } else if (memcmp(&game.formation, &fine.formation, sizeof(Formation)) != 0 ||
+                   memcmp(game.shields, fine.shields, sizeof(game.shields)) != 0 ||
+                   game.score != fine.score || game.playerLives != fine.playerLives) {
+            printf("  FAIL: step %d ended with a different game than step 1\n", step);
+            ok = false;
+        }
+        printf("  %-6d %14ld %14ld %14.1f\n", step, pointMisses, sweptMisses, ns);
+    }
+
+    int matched = 0;
+    for (int step = 1; step <= 16; step++) {
+        long diverged = FirstStepDivergence(&game, &fine, step, SWEEP_LOCKSTEP_TICKS);
+        if (diverged >= 0) {
+            printf("  FAIL: a live game at step %d diverged from single ticks at tick %ld\n", step, diverged);
+            ok = false;
+        } else {
+            matched++;
+        }
+    }
+    printf("  live game, formation moving and firing: %d of 16 step sizes match single ticks over %d ticks\n",
+           matched, SWEEP_LOCKSTEP_TICKS);
+    DestroyGame(&game);
+    DestroyGame(&fine);
+    return ok;
+}
+
+// Pool bookkeeping against a reference set, the cost of walking the live
+// bullets of a full-size pool versus scanning every slot, and the pool
+// counters of a scripted game
+static bool BenchPools(long ticks) {
+    bool ok = true;
+    enum { CAPACITY = 4096, OPERATIONS = 200000 };
+    static int ids[CAPACITY];
+    static bool present[OPERATIONS + 1];
+    static Bullet pooled[CAPACITY], slots[CAPACITY];
+    Rng rng;
+    SeedRandom(&rng, 19, 7);
+
+    // Random acquires and releases, biased to fill the pool up and run out
+    Pool pool;
+    InitPool(&pool, 1000);
+    int nextId = 0, live = 0, highWater = 0;
+    uint32_t refused = 0;
+    for (int i = 0; i < OPERATIONS && ok; i++) {
+        if (pool.count == 0 || RandomRange(&rng, 100) < 55) {
+            int slot = AcquireSlot(&pool);
+            if (slot < 0) {
+                refused++;
+            } else {
+                ids[slot] = nextId;
+                present[nextId++] = true;
+                live++;
+            }
+        } else {
+            int slot = RandomRange(&rng, pool.count);
+            present[ids[slot]] = false;
+            ReleaseSlot(&pool, ids, sizeof(int), slot);
+            live--;
+        }
+        if (live > highWater) {
+            highWater = live;
+        }
+
+        // Every live id exactly once, packed at the front
+        int found = 0;
+        for (int slot = 0; slot < pool.count; slot++) {
+            found += present[ids[slot]];
+        }
+        if (pool.count != live || found != live || pool.highWater != highWater || pool.exhausted != refused) {
+            printf("  FAIL: pool bookkeeping is off after %d operations\n", i + 1);
+            ok = false;
+        }
+    }
+
+    // Moving every live bullet once per tick: the pool walks `live` packed
+    // entries, the old layout scans all slots for the active ones
+    printf("pools: %ld ticks per point, %d slots\n", ticks, CAPACITY);
+    printf("  %-8s %14s %14s\n", "live", "pool ns/tick", "scan ns/tick");
+    for (int count = 16; count <= CAPACITY; count *= 4) {
+        InitPool(&pool, CAPACITY);
+        memset(slots, 0, sizeof(slots));
+        for (int i = 0; i < count; i++) {
+            Bullet* bullet = &pooled[AcquireSlot(&pool)];
+            bullet->active = true;
+            bullet->x = RandomRange(&rng, WINDOW_WIDTH);
+            bullet->y = RandomRange(&rng, WINDOW_HEIGHT);
+
+            // Same bullet in a random free slot of the flat array
+            int slot = RandomRange(&rng, CAPACITY);
+            while (slots[slot].active) {
+                slot = (slot + 1) % CAPACITY;
+            }
+            slots[slot] = *bullet;
+        }
+
+        long checksum = 0;
+        double start = NowNs();
+        for (long tick = 0; tick < ticks; tick++) {
+            for (int i = 0; i < pool.count; i++) {
+                pooled[i].y = (pooled[i].y + ALIEN_BULLET_SPEED) % WINDOW_HEIGHT;
+            }
+            checksum += pooled[tick % pool.count].y;
+        }
+        double poolNs = (NowNs() - start) / ticks;
+
+        start = NowNs();
+        for (long tick = 0; tick < ticks; tick++) {
+            for (int i = 0; i < CAPACITY; i++) {
+                if (slots[i].active) {
+                    slots[i].y = (slots[i].y + ALIEN_BULLET_SPEED) % WINDOW_HEIGHT;
+                }
+            }
+            checksum -= slots[tick % CAPACITY].y;
+        }
+        double scanNs = (NowNs() - start) / ticks;
+        benchSink = checksum;
+
+        printf("  %-8d %14.1f %14.1f\n", count, poolNs, scanNs);
+    }
+
+    // Counters of the classic pools over a scripted game
+    static Game game;
+    if (!CreateClassicGame(&game)) {
+        return false;
+    }
+    SeedGame(&game, 19);
+    InitializeGame(&game);
+    for (long tick = 0; tick < ticks; tick++) {
+        QueueScriptedInputs(&game);
+        UpdateGame(&game);
+    }
+    const char* names[] = {"player bullets", "alien bullets", "explosions"};
+    const Pool* pools[] = {&game.playerBulletPool, &game.alienBulletPool, &game.explosionPool};
+    printf("  scripted game, %ld ticks:\n", ticks);
+    for (int i = 0; i < 3; i++) {
+        printf("  %-16s capacity %4d, high water %4d, %6u acquires refused\n",
+               names[i], pools[i]->capacity, pools[i]->highWater, pools[i]->exhausted);
+        if (pools[i]->highWater > pools[i]->capacity) {
+            printf("  FAIL: %s went over capacity\n", names[i]);
+            ok = false;
+        }
+    }
+    DestroyGame(&game);
+    return ok;
+}
+
+// The same random particles every time, alive for 1 to maxLife ticks
+static void FillParticles(ParticleSystem* system, int count, int maxLife) {
+    Rng rng;
+    SeedRandom(&rng, 29, 3);
+    ClearParticles(system);
+    for (int i = 0; i < count; i++) {
+        float x = (float)RandomRange(&rng, WINDOW_WIDTH);
+        float y = (float)RandomRange(&rng, WINDOW_HEIGHT);
+        float vx = (float)(RandomRange(&rng, 2001) - 1000) / 250.0f;
+        float vy = (float)(RandomRange(&rng, 2001) - 1000) / 250.0f;
+        SpawnParticle(system, x, y, vx, vy, (float)(1 + RandomRange(&rng, maxLife)), RandomNext(&rng) & 0xFFFFFF);
+    }
+}
+
+static bool SameParticles(const ParticleSystem* a, const ParticleSystem* b) {
+    size_t bytes = sizeof(float) * (size_t)a->pool.count;
+    return a->pool.count == b->pool.count &&
+           memcmp(a->x, b->x, bytes) == 0 && memcmp(a->y, b->y, bytes) == 0 &&
+           memcmp(a->vx, b->vx, bytes) == 0 && memcmp(a->vy, b->vy, bytes) == 0 &&
+           memcmp(a->life, b->life, bytes) == 0 &&
+           memcmp(a->color, b->color, sizeof(uint32_t) * (size_t)a->pool.count) == 0;
+}
+
+// Particle update kernels against the scalar reference, 10k to 1M
+// particles, and a game with particles against one without
+static bool BenchParticles(long ticks) {
+    bool ok = true;
+    enum { CHECK_COUNT = 100003, CHECK_TICKS = 150, MAX_COUNT = 1000000 };
+    static ParticleSystem systems[PARTICLE_KERNEL_COUNT];
+    for (int k = 0; k < PARTICLE_KERNEL_COUNT; k++) {
+        if (!CreateParticleSystem(&systems[k], MAX_COUNT)) {
+            return false;
+        }
+        systems[k].kernel = (ParticleKernel)k;
+    }
+
+    // Every kernel must match the scalar one bit for bit, deaths and all
+    // (an odd count leaves a tail for the scalar remainder loop)
+    for (int k = 0; k < PARTICLE_KERNEL_COUNT; k++) {
+        if (ParticleKernelAvailable((ParticleKernel)k)) {
+            FillParticles(&systems[k], CHECK_COUNT, CHECK_TICKS * 2);
+        }
+    }
+    for (int t = 0; t < CHECK_TICKS; t++) {
+        for (int k = 0; k < PARTICLE_KERNEL_COUNT; k++) {
+            if (ParticleKernelAvailable((ParticleKernel)k)) {
+                UpdateParticles(&systems[k]);
+            }
+        }
+    }
+    for (int k = PARTICLE_KERNEL_SCALAR + 1; k < PARTICLE_KERNEL_COUNT; k++) {
+        if (ParticleKernelAvailable((ParticleKernel)k) &&
+            !SameParticles(&systems[PARTICLE_KERNEL_SCALAR], &systems[k])) {
+            printf("  FAIL: %s particles differ from scalar\n", ParticleKernelName((ParticleKernel)k));
+            ok = false;
+        }
+    }
+    int survivors = systems[PARTICLE_KERNEL_SCALAR].pool.count;
+
+    // Throughput with nobody dying, so every tick moves the full count
+    printf("particles: %ld ticks per point, best kernel %s, %d of %d alive after %d checked ticks\n",
+           ticks, ParticleKernelName(BestParticleKernel()), survivors, CHECK_COUNT, CHECK_TICKS);
+    printf("  %-10s %-8s %12s %12s\n", "particles", "kernel", "us/tick", "ns/particle");
+    static const int counts[] = {10000, 100000, MAX_COUNT};
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        for (int k = 0; k < PARTICLE_KERNEL_COUNT; k++) {
+            if (!ParticleKernelAvailable((ParticleKernel)k)) {
+                continue;
+            }
+            ParticleSystem* system = &systems[k];
+            FillParticles(system, counts[c], 1);
+            for (int i = 0; i < system->pool.count; i++) {
+                system->life[i] = (float)ticks + 2.0f;
+            }
+            double start = NowNs();
+            for (long t = 0; t < ticks; t++) {
+                UpdateParticles(system);
+            }
+            double perTick = (NowNs() - start) / ticks;
+            printf("  %-10d %-8s %12.1f %12.2f%s\n", counts[c], ParticleKernelName((ParticleKernel)k),
+                   perTick / 1e3, perTick / counts[c], perTick > 1e6 ? "  over the 1 ms budget" : "");
+        }
+    }
+    for (int k = 0; k < PARTICLE_KERNEL_COUNT; k++) {
+        DestroyParticleSystem(&systems[k]);
+    }
+
+    // Particles are cosmetic: attaching them must not change the game
+    static Game plain, decorated;
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.particles = DEFAULT_PARTICLE_CAPACITY;
+    if (!CreateClassicGame(&plain) || !CreateGame(&decorated, &config)) {
+        return false;
+    }
+    SeedGame(&plain, 3);
+    SeedGame(&decorated, 3);
+    InitializeGame(&plain);
+    InitializeGame(&decorated);
+    for (long t = 0; t < 20000 && ok; t++) {
+        QueueScriptedInputs(&plain);
+        QueueScriptedInputs(&decorated);
+        UpdateGame(&plain);
+        UpdateGame(&decorated);
+        if (HashGame(&plain) != HashGame(&decorated)) {
+            printf("  FAIL: particles changed the game at tick %u\n", plain.tick);
+            ok = false;
+        }
+    }
+    printf("  scripted game: particle high water %d of %d, %u spawns refused\n",
+           decorated.particles->pool.highWater, decorated.particles->pool.capacity,
+           decorated.particles->pool.exhausted);
+    DestroyGame(&plain);
+    DestroyGame(&decorated);
+    return ok;
+}
+
+// One frame of a scripted game as the window draws it, in software: a
+// tick, the background and the sprites, marked when profiled
+static void PlayProfiledFrame(Game* game, Framebuffer* frame, const Background* background,
+                              const SpriteAtlas* atlas, Profiler* profiler) {
+    if (profiler != NULL) {
+        BeginProfileFrame(profiler);
+    }
+    QueueScriptedInputs(game);
+    UpdateGame(game);
+    if (profiler != NULL) {
+        ProfileMark(profiler, PROFILE_RENDER_STARS);
+    }
+    DrawScrolledStars(background, frame, 0);
+    if (profiler != NULL) {
+        ProfileMark(profiler, PROFILE_RENDER_NEBULAE);
+    }
+    DrawScrolledNebulae(background, frame, 0);
+    if (profiler != NULL) {
+        ProfileMark(profiler, PROFILE_RENDER_ALIENS);
+    }
+    DrawSceneSprites(frame, game, atlas);
+    if (profiler != NULL) {
+        EndProfileFrame(profiler);
+    }
+}
+
+// Profiler cost against a frame, ring bookkeeping and the CSV dump
+static bool BenchProfiler(long frames) {
+    bool ok = true;
+    static Game plain, profiled;
+    static Profiler profiler;
+    static Background background;
+    SpriteAtlas atlas;
+    Framebuffer frame;
+    if (!BuildSpriteAtlas(&atlas) ||
+        !CreateFramebuffer(&frame, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateClassicGame(&plain) || !CreateClassicGame(&profiled)) {
+        return false;
+    }
+    GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+
+    InitProfiler(&profiler, ClockNs);
+    profiled.phaseMarker = ProfilePhaseMarker;
+    profiled.phaseContext = &profiler;
+    SeedGame(&plain, 5);
+    SeedGame(&profiled, 5);
+    InitializeGame(&plain);
+    InitializeGame(&profiled);
+
+    // Alternate rounds of the same frames with and without the profiler so
+    // clock drift and turbo hit both alike
+    enum { ROUNDS = 8 };
+    long perRound = frames / ROUNDS > 0 ? frames / ROUNDS : 1;
+    double plainNs = 0.0, profiledNs = 0.0;
+    for (int round = 0; round < ROUNDS; round++) {
+        double start = NowNs();
+        for (long i = 0; i < perRound; i++) {
+            PlayProfiledFrame(&plain, &frame, &background, &atlas, NULL);
+        }
+        plainNs += NowNs() - start;
+        start = NowNs();
+        for (long i = 0; i < perRound; i++) {
+            PlayProfiledFrame(&profiled, &frame, &background, &atlas, &profiler);
+        }
+        profiledNs += NowNs() - start;
+    }
+    long played = perRound * ROUNDS;
+    if (HashGame(&plain) != HashGame(&profiled)) {
+        printf("  FAIL: profiling changed the game\n");
+        ok = false;
+    }
+
+    // Every recorded frame is at least the sum of its zones
+    int recorded = RecordedProfileFrames(&profiler);
+    int expected = played < PROFILER_HISTORY ? (int)played : PROFILER_HISTORY;
+    if (recorded != expected) {
+        printf("  FAIL: %d frames in the ring, expected %d\n", recorded, expected);
+        ok = false;
+    }
+    for (int f = 0; f < recorded && ok; f++) {
+        uint64_t zones = 0;
+        for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+            zones += profiler.history[f][zone];
+        }
+        if (zones > profiler.history[f][PROFILE_COLUMN_FRAME] + PROFILE_ZONE_COUNT) {
+            printf("  FAIL: frame %d zones add up to more than the frame\n", f);
+            ok = false;
+        }
+    }
+
+    const ProfileStats* stats = UpdateProfileStats(&profiler);
+    printf("profiler: %ld frames, %.1f ns per mark\n", played, profiler.markCost);
+    printf("  %-16s %10s %10s %10s\n", "zone", "min us", "avg us", "p99 us");
+    for (int column = 0; column < PROFILE_COLUMN_COUNT; column++) {
+        if (stats[column].p99 == 0) {
+            continue;
+        }
+        printf("  %-16s %10.2f %10.2f %10.2f\n", ProfileColumnName(column),
+               stats[column].min / 1e3, stats[column].avg / 1e3, stats[column].p99 / 1e3);
+    }
+
+    // The estimate charges every mark its calibrated cost; the measured
+    // difference between the two runs is noisier but independent
+    double estimated = 100.0 * stats[PROFILE_COLUMN_OVERHEAD].avg / stats[PROFILE_COLUMN_FRAME].avg;
+    double measured = 100.0 * (profiledNs - plainNs) / plainNs;
+    printf("  overhead: estimated %.3f%% of the frame, measured %+.2f%% (%.1f vs %.1f us/frame)\n",
+           estimated, measured, plainNs / played / 1e3, profiledNs / played / 1e3);
+    if (estimated >= 1.0) {
+        printf("  FAIL: profiler costs %.2f%% of the frame, budget is 1%%\n", estimated);
+        ok = false;
+    }
+
+    // The dump has a header and one line per recorded frame
+    const char* path = "bench_profile.csv";
+    int lines = 0;
+    if (WriteProfileCsv(&profiler, path)) {
+        FILE* file = fopen(path, "r");
+        for (int c; file != NULL && (c = fgetc(file)) != EOF;) {
+            lines += c == '\n';
+        }
+        if (file != NULL) {
+            fclose(file);
+        }
+        remove(path);
+    }
+    if (lines != recorded + 1) {
+        printf("  FAIL: CSV has %d lines, expected %d\n", lines, recorded + 1);
+        ok = false;
+    }
+
+    FreeSpriteAtlas(&atlas);
+    DestroyFramebuffer(&frame);
+    DestroyGame(&plain);
+    DestroyGame(&profiled);
+    return ok;
+}
+
+// Kernel suite: each simulation step and draw routine on its own, at a few
+// entity counts, with warm and cold caches. Results print one per line as
+// "kernel count cache ns/run", the format of a baseline file, so a saved
+// run can be compared against later ones.
+#define KERNEL_MAX_COUNTS 3
+#define KERNEL_MAX_SAMPLES 101
+#define KERNEL_EVICT_BYTES (64 << 20)
+#define KERNEL_MAX_BASELINE 256
+
+// Slowdowns smaller than this are noise whatever their percentage: a few
+// kernels cost less than a clock read, so their baseline is a handful of ns
+#define KERNEL_REGRESSION_FLOOR_NS 10.0
+
+// Set from the command line
+static const char* baselinePath = NULL;     // --baseline <file>
+static const char* saveBaselinePath = NULL; // --save-baseline <file>
+static double regressionThreshold = 15.0;   // --threshold <percent>
+
+typedef struct {
+    Game game;
+    Game pristine;          // copied over game before every timed run
+    bool created;
+    Framebuffer frame;
+    const Background* background;
+    SpriteAtlas atlas;
+    Canvas canvas;          // software canvas on frame
+    int count;
+} KernelContext;
+
+typedef struct {
+    const char* name;
+    int counts[KERNEL_MAX_COUNTS]; // 0 ends the list early
+    bool (*setup)(KernelContext* context, int count);
+    void (*run)(KernelContext* context);
+    bool restore;                  // the run changes the game
+} Kernel;
+
+typedef struct {
+    char name[32];
+    int count;
+    char cache[8];
+    double ns;
+} BaselineEntry;
+
+// Make game and pristine a fresh pair for a configuration, playing level 1
+static bool PrepareKernelGame(KernelContext* context, const GameConfig* config) {
+    if (context->created) {
+        DestroyGame(&context->game);
+        DestroyGame(&context->pristine);
+        context->created = false;
+    }
+    if (!CreateGame(&context->pristine, config)) {
+        return false;
+    }
+    if (!CreateGame(&context->game, config)) {
+        DestroyGame(&context->pristine);
+        return false;
+    }
+    context->created = true;
+    SeedGame(&context->pristine, 1);
+    InitializeGame(&context->pristine);
+    context->pristine.state = GAME_PLAYING;
+    return CopyGame(&context->game, &context->pristine);
+}
+
+// Bullets spread over the world, each having moved one tick
+static void ScatterBullets(Game* game, Rng* rng, bool player, int count) {
+    Pool* pool = player ? &game->playerBulletPool : &game->alienBulletPool;
+    Bullet* bullets = player ? game->playerBullets : game->alienBullets;
+    int speed = player ? -game->config.playerBulletSpeed : game->config.alienBulletSpeed;
+    for (int n = 0; n < count; n++) {
+        int i = AcquireSlot(pool);
+        if (i < 0) {
+            return;
+        }
+        bullets[i].active = true;
+        bullets[i].x = RandomRange(rng, game->config.worldWidth);
+        bullets[i].y = RandomRange(rng, game->config.worldHeight);
+        bullets[i].prevX = bullets[i].x;
+        bullets[i].prevY = bullets[i].y - speed;
+    }
+}
+
+static void ScatterExplosions(Game* game, Rng* rng, int count) {
+    for (int n = 0; n < count; n++) {
+        int i = AcquireSlot(&game->explosionPool);
+        if (i < 0) {
+            return;
+        }
+        game->explosions[i].x = RandomRange(rng, game->config.worldWidth);
+        game->explosions[i].y = RandomRange(rng, game->config.worldHeight);
+        game->explosions[i].frame = RandomRange(rng, EXPLOSION_FRAMES);
+        game->explosions[i].timer = RandomRange(rng, EXPLOSION_DURATION);
+        game->explosions[i].active = true;
+    }
+}
+
+// Formation of about count aliens in a world wide enough to march in
+static bool SetupFormation(KernelContext* context, int count) {
+    GameConfig config;
+    DefaultGameConfig(&config);
+    if (count > ALIEN_ROWS * ALIEN_COLS) {
+        config.alienRows = count >= 10000 ? 100 : 20;
+        config.alienCols = count / config.alienRows;
+        config.worldWidth = 6400;
+        config.worldHeight = 6400;
+    }
+    return PrepareKernelGame(context, &config);
+}
+
+static void RunMoveAliens(KernelContext* context) {
+    MoveAliens(&context->game);
+}
+
+// Classic formation firing count bullets into an empty pool
+static bool SetupFire(KernelContext* context, int count) {
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.alienBullets = count;
+    context->count = count;
+    return PrepareKernelGame(context, &config);
+}
+
+static void RunFireAlienBullets(KernelContext* context) {
+    for (int i = 0; i < context->count; i++) {
+        FireAlienBullet(&context->game);
+    }
+}
+
+// Classic formation and shields, count bullets half each way
+static bool SetupCollisions(KernelContext* context, int count) {
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.playerBullets = count / 2 > 0 ? count / 2 : 1;
+    config.alienBullets = count - count / 2 > 0 ? count - count / 2 : 1;
+    if (!PrepareKernelGame(context, &config)) {
+        return false;
+    }
+    Rng rng;
+    SeedRandom(&rng, 41, 0);
+    ScatterBullets(&context->pristine, &rng, true, count / 2);
+    ScatterBullets(&context->pristine, &rng, false, count - count / 2);
+    return CopyGame(&context->game, &context->pristine);
+}
+
+static void RunCheckCollisions(KernelContext* context) {
+    CheckCollisions(&context->game);
+}
+
+// Classic shields and count alien bullets whose last tick of travel ends
+// inside a shield's box, the player well below them
+static bool SetupShieldSweeps(KernelContext* context, int count) {
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.alienBullets = count;
+    if (!PrepareKernelGame(context, &config)) {
+        return false;
+    }
+    Game* game = &context->pristine;
+    Rng rng;
+    SeedRandom(&rng, 43, 0);
+    for (int n = 0; n < count; n++) {
+        int i = AcquireSlot(&game->alienBulletPool);
+        const Shield* shield = &game->shields[RandomRange(&rng, config.shieldCount)];
+        game->alienBullets[i].active = true;
+        game->alienBullets[i].x = shield->x + RandomRange(&rng, SHIELD_WIDTH + 1);
+        game->alienBullets[i].y = shield->y + RandomRange(&rng, SHIELD_HEIGHT + 1);
+        game->alienBullets[i].prevX = game->alienBullets[i].x;
+        game->alienBullets[i].prevY = game->alienBullets[i].y - config.alienBulletSpeed;
+    }
+    if (!CopyGame(&context->game, game)) {
+        return false;
+    }
+    BuildCollisionGrid(context->game.collisionGrid, &context->game);
+    return true;
+}
+
+// The swept shield test the game runs, through the broadphase
+static void RunSweepShields(KernelContext* context) {
+    Game* game = &context->game;
+    CollideAlienBullets(game, game->collisionGrid, game->alienBullets, game->alienBulletPool.count);
+}
+
+// count explosions at random frames, some finishing on the timed tick
+static bool SetupExplosions(KernelContext* context, int count) {
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.explosions = count;
+    if (!PrepareKernelGame(context, &config)) {
+        return false;
+    }
+    Rng rng;
+    SeedRandom(&rng, 47, 0);
+    ScatterExplosions(&context->pristine, &rng, count);
+    return CopyGame(&context->game, &context->pristine);
+}
+
+static void RunUpdateExplosions(KernelContext* context) {
+    UpdateExplosions(&context->game, 1);
+}
+
+// The scene's draw routines on the software canvas, into an 800x600 frame
+
+static bool SetupDrawTarget(KernelContext* context) {
+    if (context->frame.pixels != NULL) {
+        return true;
+    }
+    static Background background;
+    if (!CreateFramebuffer(&context->frame, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !BuildSpriteAtlas(&context->atlas)) {
+        return false;
+    }
+    GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+    context->background = &background;
+    ClearFramebuffer(&context->frame, FB_RGB(0, 0, 0));
+    InitCanvas(&context->canvas, &softwareCanvas, &context->frame, &context->atlas);
+    return true;
+}
+
+// A classic game with count live aliens, count bullets and count
+// explosions scattered over the window, and count shields
+static bool SetupDraw(KernelContext* context, int count) {
+    if (!SetupDrawTarget(context)) {
+        return false;
+    }
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.playerBullets = count;
+    config.alienBullets = count;
+    config.explosions = count;
+    config.shieldCount = count < MAX_SHIELDS ? count : MAX_SHIELDS;
+    if (!PrepareKernelGame(context, &config)) {
+        return false;
+    }
+    Game* game = &context->pristine;
+    for (int i = ALIEN_ROWS * ALIEN_COLS - 1; i >= count; i--) {
+        KillAlien(&game->formation, i % ALIEN_ROWS, i / ALIEN_ROWS);
+    }
+    Rng rng;
+    SeedRandom(&rng, 53, 0);
+    ScatterBullets(game, &rng, true, count / 2);
+    ScatterBullets(game, &rng, false, count - count / 2);
+    ScatterExplosions(game, &rng, count);
+    return CopyGame(&context->game, &context->pristine);
+}
+
+static bool SetupDrawParticles(KernelContext* context, int count) {
+    if (!SetupDrawTarget(context)) {
+        return false;
+    }
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.particles = count;
+    if (!PrepareKernelGame(context, &config)) {
+        return false;
+    }
+    FillParticles(context->game.particles, count, 60);
+    return true;
+}
+
+static void RunDrawBackground(KernelContext* context) {
+    DrawScrolledBackground(context->background, &context->frame, 0);
+}
+
+static void RunDrawAliens(KernelContext* context) {
+    DrawAliens(&context->canvas, &context->game);
+}
+
+static void RunDrawPlayer(KernelContext* context) {
+    DrawPlayer(&context->canvas, &context->game, 1.0);
+}
+
+static void RunDrawBullets(KernelContext* context) {
+    DrawBullets(&context->canvas, &context->game, 1.0);
+}
+
+static void RunDrawShields(KernelContext* context) {
+    DrawShields(&context->canvas, &context->game);
+}
+
+static void RunDrawExplosions(KernelContext* context) {
+    DrawExplosions(&context->canvas, &context->game);
+}
+
+static void RunDrawParticles(KernelContext* context) {
+    DrawParticles(&context->canvas, &context->game);
+}
+
+static const Kernel kernels[] = {
+    {"move_aliens", {55, 1000, 10000}, SetupFormation, RunMoveAliens, true},
+    {"fire_alien_bullet", {8, 1000, 50000}, SetupFire, RunFireAlienBullets, true},
+    {"check_collisions", {10, 1000, 10000}, SetupCollisions, RunCheckCollisions, true},
+    {"sweep_shields", {100, 1000, 10000}, SetupShieldSweeps, RunSweepShields, true},
+    {"update_explosions", {20, 1000, 10000}, SetupExplosions, RunUpdateExplosions, true},
+    {"draw_background", {1}, SetupDraw, RunDrawBackground, false},
+    {"draw_aliens", {11, 27, 55}, SetupDraw, RunDrawAliens, false},
+    {"draw_player", {1}, SetupDraw, RunDrawPlayer, false},
+    {"draw_bullets", {10, 1000, 10000}, SetupDraw, RunDrawBullets, false},
+    {"draw_shields", {1, 4, 8}, SetupDraw, RunDrawShields, false},
+    {"draw_explosions", {20, 200, 2000}, SetupDraw, RunDrawExplosions, false},
+    {"draw_particles", {1000, 10000, 100000}, SetupDrawParticles, RunDrawParticles, false},
+};
+
+#define KERNEL_COUNT (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+// Write over a buffer bigger than the last level cache
+static void EvictCaches(void) {
+    static uint8_t* buffer;
+    if (buffer == NULL) {
+        buffer = malloc(KERNEL_EVICT_BYTES);
+        if (buffer == NULL) {
+            return;
+        }
+    }
+    static uint8_t value;
+    memset(buffer, ++value, KERNEL_EVICT_BYTES);
+    benchSink += buffer[value];
+}
+
+static int CompareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Fastest of a number of timed runs, less the cost of reading the clock:
+// the minimum is what the code costs when nothing else gets in the way,
+// which makes it the most repeatable figure from one run to the next.
+// Cold samples evict the caches after restoring the game, warm ones run
+// once untimed first.
+static double TimeKernel(const Kernel* kernel, KernelContext* context, int samples, bool cold, double clockNs) {
+    double times[KERNEL_MAX_SAMPLES];
+    if (!cold) {
+        if (kernel->restore) {
+            CopyGame(&context->game, &context->pristine);
+        }
+        kernel->run(context);
+    }
+    for (int s = 0; s < samples; s++) {
+        if (kernel->restore) {
+            CopyGame(&context->game, &context->pristine);
+        }
+        if (cold) {
+            EvictCaches();
+        }
+        double start = NowNs();
+        kernel->run(context);
+        times[s] = NowNs() - start - clockNs;
+        if (times[s] < 0.0) {
+            times[s] = 0.0;
+        }
+    }
+    double fastest = times[0];
+    for (int s = 1; s < samples; s++) {
+        if (times[s] < fastest) fastest = times[s];
+    }
+    return fastest;
+}
+
+// Baseline file: lines of "kernel count cache ns", # starts a comment
+static int LoadBaseline(const char* path, BaselineEntry* entries, int capacity) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    int count = 0;
+    char line[256];
+    while (count < capacity && fgets(line, sizeof(line), file) != NULL) {
+        BaselineEntry* entry = &entries[count];
+        if (line[0] != '#' &&
+            sscanf(line, "%31s %d %7s %lf", entry->name, &entry->count, entry->cache, &entry->ns) == 4) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static const BaselineEntry* FindBaseline(const BaselineEntry* entries, int count, const char* name,
+                                         int entities, const char* cache) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(entries[i].name, name) == 0 && entries[i].count == entities &&
+            strcmp(entries[i].cache, cache) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Every kernel at every count, warm then cold, compared with a baseline
+// when one is given. A run slower than the baseline by more than the
+// threshold, and by more ns than both the clock's own jitter and
+// KERNEL_REGRESSION_FLOOR_NS, is a regression.
+static bool BenchKernels(long samples) {
+    bool ok = true;
+    if (samples > KERNEL_MAX_SAMPLES) samples = KERNEL_MAX_SAMPLES;
+    if (samples < 1) samples = 1;
+
+    static BaselineEntry baseline[KERNEL_MAX_BASELINE];
+    int baselineCount = 0;
+    if (baselinePath != NULL) {
+        baselineCount = LoadBaseline(baselinePath, baseline, KERNEL_MAX_BASELINE);
+        if (baselineCount < 0) {
+            printf("  FAIL: cannot read baseline %s\n", baselinePath);
+            return false;
+        }
+    }
+    FILE* save = NULL;
+    if (saveBaselinePath != NULL) {
+        save = fopen(saveBaselinePath, "w");
+        if (save == NULL) {
+            printf("  FAIL: cannot write baseline %s\n", saveBaselinePath);
+            return false;
+        }
+        fprintf(save, "# kernel count cache ns/run, fastest of %ld samples\n", samples);
+    }
+
+    // What an empty timed sample costs
+    double clockTimes[KERNEL_MAX_SAMPLES];
+    for (int s = 0; s < samples; s++) {
+        double start = NowNs();
+        clockTimes[s] = NowNs() - start;
+    }
+    qsort(clockTimes, (size_t)samples, sizeof(double), CompareDoubles);
+    double clockNs = clockTimes[samples / 2];
+    double floorNs = 2.0 * clockNs > KERNEL_REGRESSION_FLOOR_NS ? 2.0 * clockNs : KERNEL_REGRESSION_FLOOR_NS;
+
+    printf("kernels: fastest of %ld samples, clock read %.0f ns subtracted", samples, clockNs);
+    if (baselinePath != NULL) {
+        printf(", against %s (+%.0f%% and %.0f ns allowed)", baselinePath, regressionThreshold, floorNs);
+    }
+    printf("\n  %-20s %7s %-5s %12s %10s\n", "# kernel", "count", "cache", "ns/run", "baseline");
+
+    static KernelContext context;
+    int regressions = 0;
+    for (int k = 0; k < KERNEL_COUNT && ok; k++) {
+        const Kernel* kernel = &kernels[k];
+        for (int c = 0; c < KERNEL_MAX_COUNTS && kernel->counts[c] > 0; c++) {
+            int count = kernel->counts[c];
+            if (!kernel->setup(&context, count)) {
+                printf("  FAIL: cannot set up %s for %d\n", kernel->name, count);
+                ok = false;
+                break;
+            }
+            for (int cold = 0; cold < 2; cold++) {
+                const char* cache = cold ? "cold" : "warm";
+                double ns = TimeKernel(kernel, &context, (int)samples, cold, clockNs);
+                printf("  %-20s %7d %-5s %12.1f", kernel->name, count, cache, ns);
+                if (save != NULL) {
+                    fprintf(save, "%-20s %7d %-5s %12.1f\n", kernel->name, count, cache, ns);
+                }
+
+                const BaselineEntry* entry = FindBaseline(baseline, baselineCount, kernel->name, count, cache);
+                if (entry != NULL) {
+                    double change = entry->ns > 0.0 ? 100.0 * (ns - entry->ns) / entry->ns : 0.0;
+                    bool regressed = ns - entry->ns > floorNs && (entry->ns <= 0.0 || change > regressionThreshold);
+                    printf(" %10.1f %+6.0f%%%s", entry->ns, change, regressed ? "  REGRESSION" : "");
+                    regressions += regressed;
+                }
+                printf("\n");
+            }
+        }
+    }
+
+    if (regressions > 0) {
+        printf("  FAIL: %d kernels slower than the baseline by more than %.0f%%\n", regressions,
+               regressionThreshold);
+        ok = false;
+    }
+    if (save != NULL && fclose(save) != 0) {
+        printf("  FAIL: cannot write baseline %s\n", saveBaselinePath);
+        ok = false;
+    }
+    if (context.created) {
+        DestroyGame(&context.game);
+        DestroyGame(&context.pristine);
+        context.created = false;
+    }
+    if (context.frame.pixels != NULL) {
+        DestroyFramebuffer(&context.frame);
+        FreeSpriteAtlas(&context.atlas);
+    }
+    return ok;
+}
+
+// Golden frame hashes for the raster benchmark, "tick hash" per line
+static const char* goldenPath = "baselines/golden.txt"; // --golden <file>
+static bool saveGolden = false;                          // --save-golden
+
+#define RASTER_GOLDEN_FRAMES 10
+#define RASTER_GOLDEN_INTERVAL 300
+
+// Plain loop fill, what the span fills are measured against
+static void ReferenceFillRectangle(Framebuffer* fb, int left, int top, int right, int bottom, uint32_t color) {
+    for (int y = top; y < bottom; y++) {
+        uint32_t* row = fb->pixels + (size_t)y * fb->stride;
+        for (int x = left; x < right; x++) {
+            row[x] = color;
+        }
+    }
+}
+
+static uint64_t HashFramebuffer(const Framebuffer* fb) {
+    uint64_t hash = 14695981039346656037ull;
+    for (int y = 0; y < fb->height; y++) {
+        const uint32_t* row = fb->pixels + (size_t)y * fb->stride;
+        for (int x = 0; x < fb->width; x++) {
+            hash = (hash ^ row[x]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static bool SameFramebuffer(const Framebuffer* a, const Framebuffer* b) {
+    return memcmp(a->pixels, b->pixels, (size_t)a->width * a->height * sizeof(uint32_t)) == 0;
+}
+
+// The playfield over the background, as the window draws it
+static void DrawScene(Canvas* canvas, const Game* game, bool withParticles) {
+    DrawShields(canvas, game);
+    if (game->state == GAME_PLAYING) {
+        DrawPlayer(canvas, game, 1.0);
+    }
+    DrawAliens(canvas, game);
+    DrawBullets(canvas, game, 1.0);
+    DrawExplosions(canvas, game);
+    if (withParticles) {
+        DrawParticles(canvas, game);
+    }
+}
+
+// A whole frame as the window draws it with --software
+static void DrawSoftwareFrame(Canvas* canvas, const Background* background, const Game* game) {
+    DrawScrolledBackground(background, canvas->surface, 0);
+    DrawScene(canvas, game, true);
+}
+
+// Software rasterizer: span fills against a plain loop, triangles against
+// the general polygon fill, whole 800x600 frames of a scripted game timed
+// and compared with golden hashes
+static bool BenchRaster(long frames) {
+    bool ok = true;
+    static Game game;
+    static Background background;
+    SpriteAtlas atlas;
+    Framebuffer frame, reference;
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.particles = DEFAULT_PARTICLE_CAPACITY;
+    if (!BuildSpriteAtlas(&atlas) ||
+        !CreateFramebuffer(&frame, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateFramebuffer(&reference, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateGame(&game, &config)) {
+        return false;
+    }
+    GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+
+    // Rectangles of every width and alignment, span fill against the loop
+    Rng rng;
+    SeedRandom(&rng, 61, 0);
+    ClearFramebuffer(&frame, 0);
+    ClearFramebuffer(&reference, 0);
+    for (int i = 0; i < 20000; i++) {
+        int left = RandomRange(&rng, WINDOW_WIDTH + 40) - 20;
+        int top = RandomRange(&rng, WINDOW_HEIGHT + 40) - 20;
+        int right = left + RandomRange(&rng, 70);
+        int bottom = top + RandomRange(&rng, 40);
+        uint32_t color = RandomNext(&rng) & 0xFFFFFF;
+        FillRectangle(&frame, left, top, right, bottom, color);
+        ReferenceFillRectangle(&reference, left < 0 ? 0 : left, top < 0 ? 0 : top,
+                               right > WINDOW_WIDTH ? WINDOW_WIDTH : right,
+                               bottom > WINDOW_HEIGHT ? WINDOW_HEIGHT : bottom, color);
+    }
+    if (!SameFramebuffer(&frame, &reference)) {
+        printf("  FAIL: span fills differ from the plain loop\n");
+        ok = false;
+    }
+
+    // A repeated last point adds a flat edge that crosses nothing, so the
+    // four-point polygon takes the general path and must match the triangle
+    ClearFramebuffer(&frame, 0);
+    ClearFramebuffer(&reference, 0);
+    for (int i = 0; i < 20000; i++) {
+        int points[8];
+        for (int p = 0; p < 3; p++) {
+            points[p * 2] = RandomRange(&rng, WINDOW_WIDTH + 100) - 50;
+            points[p * 2 + 1] = RandomRange(&rng, WINDOW_HEIGHT + 100) - 50;
+        }
+        points[6] = points[4];
+        points[7] = points[5];
+        uint32_t color = RandomNext(&rng) & 0xFFFFFF;
+        FillTriangle(&frame, points[0], points[1], points[2], points[3], points[4], points[5], color);
+        FillPolygon(&reference, points, 4, color);
+    }
+    if (!SameFramebuffer(&frame, &reference)) {
+        printf("  FAIL: triangle fill differs from the polygon fill\n");
+        ok = false;
+    }
+
+    // Full-screen fills, the widest spans there are
+    double start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        ReferenceFillRectangle(&reference, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, (uint32_t)i);
+    }
+    double loopFill = (NowNs() - start) / frames;
+    start = NowNs();
+    for (long i = 0; i < frames; i++) {
+        FillRectangle(&frame, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, (uint32_t)i);
+    }
+    double spanFill = (NowNs() - start) / frames;
+
+    // Golden frames of a scripted game with particles, and the cost of
+    // drawing every frame on the way
+    Canvas canvas;
+    InitCanvas(&canvas, &softwareCanvas, &frame, &atlas);
+    uint64_t hashes[RASTER_GOLDEN_FRAMES];
+    SeedGame(&game, 7);
+    InitializeGame(&game);
+    double drawNs = 0.0;
+    long drawn = 0;
+    for (int g = 0; g < RASTER_GOLDEN_FRAMES; g++) {
+        for (int t = 0; t < RASTER_GOLDEN_INTERVAL; t++) {
+            QueueScriptedInputs(&game);
+            UpdateGame(&game);
+            if (drawn < frames) {
+                start = NowNs();
+                DrawSoftwareFrame(&canvas, &background, &game);
+                drawNs += NowNs() - start;
+                drawn++;
+            }
+        }
+        DrawSoftwareFrame(&canvas, &background, &game);
+        hashes[g] = HashFramebuffer(&frame);
+    }
+
+    printf("raster: 800x600 software frames, %ld drawn\n", drawn);
+    printf("  full-screen fill: loop %.1f us, span %.1f us\n", loopFill / 1e3, spanFill / 1e3);
+    printf("  scripted game frame: %.1f us (background, shields, ships, bullets, explosions, particles)\n",
+           drawn > 0 ? drawNs / drawn / 1e3 : 0.0);
+
+    if (saveGolden) {
+        FILE* file = fopen(goldenPath, "w");
+        for (int g = 0; file != NULL && g < RASTER_GOLDEN_FRAMES; g++) {
+            fprintf(file, "%d %016llx\n", (g + 1) * RASTER_GOLDEN_INTERVAL, (unsigned long long)hashes[g]);
+        }
+        if (file == NULL || fclose(file) != 0) {
+            printf("  FAIL: cannot write %s\n", goldenPath);
+            ok = false;
+        } else {
+            printf("  golden hashes saved to %s\n", goldenPath);
+        }
+    } else {
+        FILE* file = fopen(goldenPath, "r");
+        if (file == NULL) {
+            printf("  no golden file %s, frames not compared\n", goldenPath);
+        } else {
+            // Replay to each differing frame to dump it for inspection
+            int tick;
+            unsigned long long expected;
+            int compared = 0;
+            while (fscanf(file, "%d %llx", &tick, &expected) == 2) {
+                int g = tick / RASTER_GOLDEN_INTERVAL - 1;
+                if (g < 0 || g >= RASTER_GOLDEN_FRAMES || tick % RASTER_GOLDEN_INTERVAL != 0) {
+                    continue;
+                }
+                compared++;
+                if (hashes[g] == expected) {
+                    continue;
+                }
+                char path[64];
+                snprintf(path, sizeof(path), "raster_%d.ppm", tick);
+                SeedGame(&game, 7);
+                InitializeGame(&game);
+                while ((int)game.tick < tick) {
+                    QueueScriptedInputs(&game);
+                    UpdateGame(&game);
+                }
+                DrawSoftwareFrame(&canvas, &background, &game);
+                WriteFramebufferPpm(&frame, path);
+                printf("  FAIL: frame at tick %d differs from the golden image, written to %s\n", tick, path);
+                ok = false;
+            }
+            fclose(file);
+            printf("  %d frames compared with %s\n", compared, goldenPath);
+        }
+    }
+
+    FreeSpriteAtlas(&atlas);
+    DestroyFramebuffer(&frame);
+    DestroyFramebuffer(&reference);
+    DestroyGame(&game);
+    return ok;
+}
+
+// The same frame drawn straight onto the canvas and through the command
+// buffer: the target's primitives and state changes, and the frame time
+static bool BenchBatching(long frames) {
+    bool ok = true;
+    static Game game;
+    static Background background;
+    static CommandBuffer buffer;
+    SpriteAtlas atlas;
+    Framebuffer layer, frame, reference;
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.particles = DEFAULT_PARTICLE_CAPACITY;
+    if (!BuildSpriteAtlas(&atlas) ||
+        !CreateFramebuffer(&layer, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateFramebuffer(&frame, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateFramebuffer(&reference, WINDOW_WIDTH, WINDOW_HEIGHT) ||
+        !CreateCommandBuffer(&buffer, DEFAULT_COMMAND_CAPACITY, DEFAULT_COMMAND_POINTS) ||
+        !CreateGame(&game, &config)) {
+        return false;
+    }
+    GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+    ClearFramebuffer(&layer, FB_RGB(0, 0, 0));
+    DrawBackgroundDots(&background, &layer);
+
+    Canvas direct, target, recorder;
+    InitCanvas(&recorder, &commandCanvas, &buffer, &atlas);
+    long directPrimitives = 0, directChanges = 0, recorded = 0, batchedPrimitives = 0, batchedChanges = 0;
+    double directNs = 0.0, batchedNs = 0.0;
+    long mismatches = 0, firstMismatch = -1;
+    SeedGame(&game, 7);
+    InitializeGame(&game);
+    for (long f = 0; f < frames; f++) {
+        QueueScriptedInputs(&game);
+        UpdateGame(&game);
+
+        InitCanvas(&direct, &softwareCanvas, &reference, &atlas);
+        double start = NowNs();
+        BlitBackground(&reference, &layer, 0);
+        DrawScene(&direct, &game, true);
+        directNs += NowNs() - start;
+        directPrimitives += direct.primitives;
+        directChanges += direct.stateChanges;
+
+        InitCanvas(&target, &softwareCanvas, &frame, &atlas);
+        start = NowNs();
+        BlitBackground(&frame, &layer, 0);
+        BeginCommands(&buffer, &target);
+        DrawScene(&recorder, &game, true);
+        FlushCommands(&buffer);
+        batchedNs += NowNs() - start;
+        recorded += buffer.recorded;
+        batchedPrimitives += target.primitives;
+        batchedChanges += target.stateChanges;
+
+        // Only overlapping particles may come out differently, so pixels are
+        // compared without them
+        if (f % 10 == 0) {
+            BlitBackground(&reference, &layer, 0);
+            DrawScene(&direct, &game, false);
+            BlitBackground(&frame, &layer, 0);
+            BeginCommands(&buffer, &target);
+            DrawScene(&recorder, &game, false);
+            FlushCommands(&buffer);
+            if (!SameFramebuffer(&frame, &reference)) {
+                if (firstMismatch < 0) firstMismatch = (long)game.tick;
+                mismatches++;
+            }
+        }
+    }
+
+    printf("batching: scripted game with particles, %ld frames at 800x600\n", frames);
+    printf("  %-9s %12s %14s %10s\n", "", "primitives", "state changes", "frame us");
+    printf("  %-9s %12.1f %14.1f %10.1f\n", "direct", (double)directPrimitives / frames,
+           (double)directChanges / frames, directNs / frames / 1e3);
+    printf("  %-9s %12.1f %14.1f %10.1f\n", "batched", (double)batchedPrimitives / frames,
+           (double)batchedChanges / frames, batchedNs / frames / 1e3);
+    printf("  %.1f commands recorded per frame, %.1f merged into spans\n", (double)recorded / frames,
+           (double)(recorded - batchedPrimitives) / frames);
+    if (recorded != directPrimitives) {
+        printf("  FAIL: %ld commands recorded for %ld direct primitives\n", recorded, directPrimitives);
+        ok = false;
+    }
+    if (batchedChanges > directChanges) {
+        printf("  FAIL: batching added state changes\n");
+        ok = false;
+    }
+    if (mismatches > 0) {
+        printf("  FAIL: %ld batched frames differ from direct drawing, first at tick %ld\n",
+               mismatches, firstMismatch);
+        ok = false;
+    }
+
+    FreeSpriteAtlas(&atlas);
+    DestroyFramebuffer(&layer);
+    DestroyFramebuffer(&frame);
+    DestroyFramebuffer(&reference);
+    DestroyCommandBuffer(&buffer);
+    DestroyGame(&game);
+    return ok;
+}
+
+// Simulation rate of the snapshot benchmark, and the frame time of its
+// deliberately slow renderer
+#define SNAPSHOT_TICK_NS 2000000LL
+#define SNAPSHOT_SLOW_FRAME_NS 20000000LL
+
+static void SleepUntilNs(int64_t deadline) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline / NS_PER_SECOND);
+    ts.tv_nsec = (long)(deadline % NS_PER_SECOND);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+    }
+}
+
+// Renderer side of the snapshot benchmark. Every snapshot it takes must
+// hash like the game did when it was published, and ticks never go back.
+typedef struct {
+    SnapshotBuffer* snapshots;  // NULL when rendering on the simulation thread
+    const uint64_t* hashes;     // by tick, written before each publish
+    Canvas* canvas;
+    const Background* background;
+    int64_t frameNs;            // each frame is padded to this, 0 for none
+    int stop;
+    long frames;
+    long torn;
+    long backwards;
+    uint32_t lastTick;
+} SnapshotRenderer;
+
+static void RenderSnapshotFrame(SnapshotRenderer* renderer, const Game* game) {
+    int64_t start = ClockNs();
+    DrawScrolledBackground(renderer->background, renderer->canvas->surface, 0);
+    DrawScene(renderer->canvas, game, true);
+    renderer->frames++;
+    if (renderer->frameNs > 0) {
+        SleepUntilNs(start + renderer->frameNs);
+    }
+}
+
+static void* SnapshotRenderMain(void* argument) {
+    SnapshotRenderer* renderer = argument;
+    while (!__atomic_load_n(&renderer->stop, __ATOMIC_ACQUIRE)) {
+        const Snapshot* snapshot = AcquireSnapshot(renderer->snapshots);
+        const Game* game = &snapshot->game;
+        if (HashGame(game) != renderer->hashes[game->tick]) {
+            renderer->torn++;
+        }
+        if (game->tick < renderer->lastTick) {
+            renderer->backwards++;
+        }
+        renderer->lastTick = game->tick;
+        RenderSnapshotFrame(renderer, game);
+    }
+    return NULL;
+}
+
+typedef struct {
+    double intervalNs;  // average time from one tick to the next
+    double jitterNs;    // standard deviation of the tick interval
+    double p99Ns;       // 99th percentile distance of an interval from the period
+    double maxNs;
+    double publishNs;   // average cost of a publish
+    long frames;
+} TickTiming;
+
+// Tick a scripted game on a fixed schedule and time when each tick really
+// starts. The renderer either draws after every tick on this thread, the
+// way the window used to, or runs on its own thread from the snapshots.
+static bool RunSnapshotTicks(long ticks, bool threaded, int64_t frameNs, const Background* background,
+                             const SpriteAtlas* atlas, Framebuffer* frame, TickTiming* timing) {
+    static Game game;
+    static SnapshotBuffer snapshots;
+    GameConfig config;
+    DefaultGameConfig(&config);
+    config.particles = DEFAULT_PARTICLE_CAPACITY;
+    uint64_t* hashes = malloc(sizeof(uint64_t) * (size_t)(ticks + 1));
+    double* deviations = malloc(sizeof(double) * (size_t)ticks);
+    if (hashes == NULL || deviations == NULL || !CreateGame(&game, &config)) {
+        free(hashes);
+        free(deviations);
+        return false;
+    }
+    SeedGame(&game, 7);
+    InitializeGame(&game);
+    hashes[0] = HashGame(&game);
+
+    Canvas canvas;
+    InitCanvas(&canvas, &softwareCanvas, frame, atlas);
+    SnapshotRenderer renderer;
+    memset(&renderer, 0, sizeof(renderer));
+    renderer.hashes = hashes;
+    renderer.canvas = &canvas;
+    renderer.background = background;
+    renderer.frameNs = frameNs;
+    pthread_t thread;
+    bool ok = true;
+    if (threaded) {
+        if (!CreateSnapshotBuffer(&snapshots, &game, ClockNs())) {
+            DestroyGame(&game);
+            free(hashes);
+            free(deviations);
+            return false;
+        }
+        renderer.snapshots = &snapshots;
+        if (pthread_create(&thread, NULL, SnapshotRenderMain, &renderer) != 0) {
+            threaded = false;
+            ok = false;
+        }
+    }
+
+    double sum = 0.0, sumSquares = 0.0, publishNs = 0.0;
+    int64_t start = ClockNs() + SNAPSHOT_TICK_NS;
+    int64_t previous = 0;
+    for (long t = 0; t < ticks; t++) {
+        SleepUntilNs(start + t * SNAPSHOT_TICK_NS);
+        int64_t now = ClockNs();
+        if (t > 0) {
+            double interval = (double)(now - previous);
+            sum += interval;
+            sumSquares += interval * interval;
+            deviations[t - 1] = fabs(interval - SNAPSHOT_TICK_NS);
+        }
+        previous = now;
+
+        QueueScriptedInputs(&game);
+        UpdateGame(&game);
+        hashes[game.tick] = HashGame(&game);
+        if (threaded) {
+            int64_t before = ClockNs();
+            PublishSnapshot(&snapshots, &game, before);
+            publishNs += (double)(ClockNs() - before);
+        } else {
+            RenderSnapshotFrame(&renderer, &game);
+        }
+    }
+
+    if (threaded) {
+        __atomic_store_n(&renderer.stop, 1, __ATOMIC_RELEASE);
+        pthread_join(thread, NULL);
+        DestroySnapshotBuffer(&snapshots);
+    }
+
+    long intervals = ticks - 1;
+    double mean = sum / intervals;
+    qsort(deviations, (size_t)intervals, sizeof(double), CompareDoubles);
+    timing->intervalNs = mean;
+    timing->jitterNs = sqrt(fmax(sumSquares / intervals - mean * mean, 0.0));
+    timing->p99Ns = deviations[(intervals - 1) * 99 / 100];
+    timing->maxNs = deviations[intervals - 1];
+    timing->publishNs = threaded ? publishNs / ticks : 0.0;
+    timing->frames = renderer.frames;
+
+    if (renderer.torn > 0 || renderer.backwards > 0) {
+        printf("  FAIL: renderer saw %ld torn snapshots and went back %ld times\n",
+               renderer.torn, renderer.backwards);
+        ok = false;
+    }
+    DestroyGame(&game);
+    free(hashes);
+    free(deviations);
+    return ok;
+}
+
+// Tick timing with the renderer on the simulation thread and on its own,
+// each with a fast and a deliberately slow renderer
+static bool BenchSnapshots(long ticks) {
+    bool ok = true;
+    static Background background;
+    SpriteAtlas atlas;
+    Framebuffer frame;
+    if (ticks < 2) {
+        ticks = 2;
+    }
+    if (!BuildSpriteAtlas(&atlas) ||
+        !CreateFramebuffer(&frame, WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        return false;
+    }
+    GenerateBackground(&background, WINDOW_WIDTH, WINDOW_HEIGHT, BACKGROUND_SEED);
+
+    printf("snapshots: %ld ticks every %.1f ms, slow renderer %.0f ms per frame\n", ticks,
+           SNAPSHOT_TICK_NS / 1e6, SNAPSHOT_SLOW_FRAME_NS / 1e6);
+    printf("  %-22s %10s %10s %10s %10s %8s %11s\n", "tick timing, us", "interval", "jitter", "p99",
+           "max", "frames", "publish us");
+    static const struct {
+        const char* name;
+        bool threaded;
+        int64_t frameNs;
+    } modes[] = {
+        {"same thread, fast", false, 0},
+        {"same thread, slow", false, SNAPSHOT_SLOW_FRAME_NS},
+        {"render thread, fast", true, 0},
+        {"render thread, slow", true, SNAPSHOT_SLOW_FRAME_NS},
+    };
+    for (int m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+        TickTiming timing;
+        if (!RunSnapshotTicks(ticks, modes[m].threaded, modes[m].frameNs, &background, &atlas, &frame, &timing)) {
+            ok = false;
+            continue;
+        }
+        printf("  %-22s %10.1f %10.1f %10.1f %10.1f %8ld %11.2f\n", modes[m].name,
+               timing.intervalNs / 1e3, timing.jitterNs / 1e3,
+               timing.p99Ns / 1e3, timing.maxNs / 1e3, timing.frames, timing.publishNs / 1e3);
+
+        // Off the simulation thread, even a renderer ten ticks slow must
+        // leave the tick schedule alone
+        if (modes[m].threaded && modes[m].frameNs > 0 && timing.p99Ns > SNAPSHOT_SLOW_FRAME_NS / 2) {
+            printf("  FAIL: the slow renderer still delays ticks\n");
+            ok = false;
+        }
+    }
+
+    FreeSpriteAtlas(&atlas);
+    DestroyFramebuffer(&frame);
+    return ok;
+}
+
+// Save states are checked every few hundred ticks of a scripted game, and
+// a restored game must then play on exactly like the original
+#define SAVE_STATE_CHECK_INTERVAL 250
+#define SAVE_STATE_LOCKSTEP_TICKS 300
+#define SAVE_STATE_REPEATS 200000
+#define SAVE_STATE_BUDGET_NS 1000.0
+
+// Average cost of saving a game and of restoring the blob into another one
+static bool TimeSaveState(const Game* game, Game* target, uint8_t* blob, size_t capacity,
+                          size_t* size, double* saveNs, double* restoreNs) {
+    bool ok = true;
+    double start = NowNs();
+    for (long i = 0; i < SAVE_STATE_REPEATS; i++) {
+        *size = SaveGameState(game, blob, capacity);
+        benchSink += (long)*size;
+    }
+    *saveNs = (NowNs() - start) / SAVE_STATE_REPEATS;
+
+    start = NowNs();
+    for (long i = 0; i < SAVE_STATE_REPEATS; i++) {
+        ok &= RestoreGameState(target, blob, *size);
+    }
+    *restoreNs = (NowNs() - start) / SAVE_STATE_REPEATS;
+    return ok && *size > 0 && HashGame(target) == HashGame(game);
+}
+
+// Save and restore a scripted game: round trips, refused blobs, blob size
+// and the cost of both directions against CopyGame
+static bool BenchSaveState(long ticks) {
+    bool ok = true;
+    static Game live, restored, probe, stress, stressRestored, cosmetic;
+    static uint8_t blob[4096], again[4096], damaged[4096];
+    GameConfig cosmeticConfig;
+    DefaultGameConfig(&cosmeticConfig);
+    cosmeticConfig.particles = DEFAULT_PARTICLE_CAPACITY;
+    GameConfig stressConfig;
+    DefaultGameConfig(&stressConfig);
+    stressConfig.alienRows = 100;
+    stressConfig.alienCols = 100;
+    stressConfig.playerBullets = 64;
+    stressConfig.alienBullets = 256;
+    stressConfig.alienVolley = 8;
+    stressConfig.alienShootDelay = 2;
+    if (!CreateClassicGame(&live) || !CreateClassicGame(&restored) || !CreateClassicGame(&probe) ||
+        !CreateGame(&stress, &stressConfig) || !CreateGame(&stressRestored, &stressConfig) ||
+        !CreateGame(&cosmetic, &cosmeticConfig)) {
+        return false;
+    }
+    SeedGame(&live, 99);
+    InitializeGame(&live);
+    SeedGame(&restored, 7);
+    InitializeGame(&restored);
+
+    // Saved with this tick's inputs queued, so pending inputs are covered
+    long roundTrips = 0;
+    size_t size = 0, largest = 0;
+    for (long tick = 0; tick < ticks && ok; tick++) {
+        QueueScriptedInputs(&live);
+        if (tick % SAVE_STATE_CHECK_INTERVAL == 0) {
+            size = SaveGameState(&live, blob, sizeof(blob));
+            if (size == 0 || !RestoreGameState(&restored, blob, size) ||
+                HashGame(&restored) != HashGame(&live) ||
+                SaveGameState(&restored, again, sizeof(again)) != size || memcmp(blob, again, size) != 0) {
+                printf("  FAIL: save state did not round-trip at tick %ld\n", tick);
+                ok = false;
+                break;
+            }
+            CopyGame(&probe, &live);
+            for (int t = 0; t < SAVE_STATE_LOCKSTEP_TICKS; t++) {
+                UpdateGame(&probe);
+                UpdateGame(&restored);
+                if (HashGame(&probe) != HashGame(&restored)) {
+                    printf("  FAIL: restored game diverged %d ticks after tick %ld\n", t + 1, tick);
+                    ok = false;
+                    break;
+                }
+                QueueScriptedInputs(&probe);
+                QueueScriptedInputs(&restored);
+            }
+            if (size > largest) {
+                largest = size;
+            }
+            roundTrips++;
+        }
+        UpdateGame(&live);
+    }
+    if (!ok) {
+        DestroyGame(&live);
+        DestroyGame(&restored);
+        DestroyGame(&probe);
+        DestroyGame(&stress);
+        DestroyGame(&stressRestored);
+        DestroyGame(&cosmetic);
+        return false;
+    }
+
+    // Blobs from another version, another configuration or cut short are
+    // refused, and so are values the simulation never produces (a zero
+    // delay would spin UpdateGame forever). Refused blobs leave the game
+    // as it was, and a good one still restores after them.
+    long refusedWrong = 0;
+    size_t untouchedSize = SaveGameState(&restored, again, sizeof(again));
+    size = SaveGameState(&live, blob, sizeof(blob));
+    memcpy(damaged, blob, size);
+    damaged[0] ^= 1;
+    refusedWrong += !RestoreGameState(&restored, damaged, size);
+    damaged[0] ^= 1;
+    damaged[4]++;
+    refusedWrong += !RestoreGameState(&restored, damaged, size);
+    refusedWrong += !RestoreGameState(&stress, blob, size);
+    long refusedShort = 0;
+    for (size_t length = 0; length < size; length++) {
+        refusedShort += !RestoreGameState(&restored, blob, length);
+    }
+    long refusedHostile = 0;
+    for (int c = 0; c < 6; c++) {
+        CopyGame(&probe, &live);
+        switch (c) {
+            case 0: probe.alienMoveDelay = 0; break;
+            case 1: probe.alienShootDelay = -3; break;
+            case 2: probe.stepTicks = 0; break;
+            case 3: probe.formation.width = 0; break;
+            case 4: probe.rng.increment &= ~1ull; break;
+            default: probe.level = probe.config.levels + 2; break;
+        }
+        size_t hostileSize = SaveGameState(&probe, damaged, sizeof(damaged));
+        refusedHostile += !RestoreGameState(&restored, damaged, hostileSize);
+    }
+    if (refusedWrong != 3 || refusedShort != (long)size || refusedHostile != 6) {
+        printf("  FAIL: %ld of 3 foreign, %ld of %zu truncated and %ld of 6 out-of-range blobs refused\n",
+               refusedWrong, refusedShort, size, refusedHostile);
+        ok = false;
+    }
+    // Particles are not saved, so a game that only differs in them loads it
+    if (!RestoreGameState(&cosmetic, blob, size) || HashGame(&cosmetic) != HashGame(&live)) {
+        printf("  FAIL: a blob was refused by a game with another particle count\n");
+        ok = false;
+    }
+    if (SaveGameState(&restored, damaged, sizeof(damaged)) != untouchedSize ||
+        memcmp(damaged, again, untouchedSize) != 0) {
+        printf("  FAIL: a refused blob changed the game\n");
+        ok = false;
+    }
+    if (!RestoreGameState(&restored, blob, size) || HashGame(&restored) != HashGame(&live)) {
+        printf("  FAIL: a good blob no longer restores after refused ones\n");
+        ok = false;
+    }
+
+    // A stress game with its formation half shot down
+    SeedGame(&stress, 99);
+    InitializeGame(&stress);
+    for (int row = 0; row < stress.formation.rows; row++) {
+        for (int col = row & 1; col < stress.formation.cols; col += 2) {
+            KillAlien(&stress.formation, row, col);
+        }
+    }
+    for (int tick = 0; tick < 600; tick++) {
+        QueueScriptedInputs(&stress);
+        UpdateGame(&stress);
+    }
+    size_t stressCapacity = SaveStateCapacity(&stress);
+    uint8_t* stressBlob = malloc(stressCapacity);
+    if (stressBlob == NULL) {
+        ok = false;
+    }
+
+    double copyStart = NowNs();
+    for (long i = 0; i < SAVE_STATE_REPEATS; i++) {
+        CopyGame(&probe, &live);
+        benchSink += probe.tick;
+    }
+    double copyNs = (NowNs() - copyStart) / SAVE_STATE_REPEATS;
+
+    size_t classicSize = 0, stressSize = 0;
+    double classicSave, classicRestore, stressSave = 0, stressRestore = 0;
+    if (!TimeSaveState(&live, &restored, blob, sizeof(blob), &classicSize, &classicSave, &classicRestore) ||
+        (stressBlob != NULL &&
+         !TimeSaveState(&stress, &stressRestored, stressBlob, stressCapacity, &stressSize, &stressSave, &stressRestore))) {
+        printf("  FAIL: timed restores did not reproduce the game\n");
+        ok = false;
+    }
+
+    printf("savestate: %ld ticks, %ld round trips each followed by %d ticks in lockstep, largest blob %zu bytes\n",
+           ticks, roundTrips, SAVE_STATE_LOCKSTEP_TICKS, largest);
+    printf("  %-14s %8s %10s %10s %10s\n", "config", "bytes", "capacity", "save ns", "restore ns");
+    printf("  %-14s %8zu %10zu %10.1f %10.1f\n", "classic", classicSize, SaveStateCapacity(&live),
+           classicSave, classicRestore);
+    printf("  %-14s %8zu %10zu %10.1f %10.1f\n", "100x100", stressSize, stressCapacity, stressSave, stressRestore);
+    printf("  CopyGame %.1f ns for %zu bytes of state\n", copyNs, offsetof(Game, playerBullets));
+    if (classicSave >= SAVE_STATE_BUDGET_NS || classicRestore >= SAVE_STATE_BUDGET_NS) {
+        printf("  FAIL: a classic save or restore takes a microsecond or more\n");
+        ok = false;
+    }
+
+    free(stressBlob);
+    DestroyGame(&live);
+    DestroyGame(&restored);
+    DestroyGame(&probe);
+    DestroyGame(&stress);
+    DestroyGame(&stressRestored);
+    DestroyGame(&cosmetic);
+    return ok;
+}
+
+static const Benchmark benchmarks[] = {
+    {"ticks", "UpdateGame throughput with a scripted player", 5000000, BenchTicks},
+    {"loop", "fixed-timestep loop on a fake clock", 5000000, BenchLoop},
+    {"replay", "record, encode and replay a session at full speed", 1000000, BenchReplay},
+    {"lockstep", "same seed, same inputs, bit-identical games", 200000, BenchLockstep},
+    {"target", "persistent back buffer allocations and clear cost", 2000, BenchTarget},
+    {"background", "starfield blitted from a baked layer versus drawn direct", 2000, BenchBackground},
+    {"formation", "alien formation moves and hit tests from 5x11 to 100x100", 20000, BenchFormation},
+    {"shooters", "formation edges and shooter choice as the aliens die", 200000, BenchShooters},
+    {"shields", "bullet-vs-shield hits, per-block records versus bitmap", 1000000, BenchShields},
+    {"broadphase", "collision grid versus brute force, 10 to n bullets", 100000, BenchBroadphase},
+    {"sweep", "swept bullets at 1 to 16 ticks per update against per-tick points", 2000, BenchSweep},
+    {"pools", "bullet and explosion pools, live walk versus full scan", 20000, BenchPools},
+    {"sprites", "aliens, player and explosions from shapes versus the atlas", 500, BenchSprites},
+    {"explosions", "hundreds of explosions, trig shapes, particle table and batched blits", 200, BenchExplosions},
+    {"particles", "SoA particle update, scalar versus SSE2 and AVX2, 10k to 1M", 200, BenchParticles},
+    {"profiler", "per-phase frame profiler overhead, stats and CSV dump", 4000, BenchProfiler},
+    {"kernels", "simulation and draw kernels, warm and cold, against a baseline", 25, BenchKernels},
+    {"raster", "software rasterizer: span fills, triangles, 800x600 frames, golden images", 3000, BenchRaster},
+    {"batching", "draw calls through a state-sorted command buffer versus direct", 3000, BenchBatching},
+    {"snapshots", "tick timing with the renderer on the simulation thread or its own", 500, BenchSnapshots},
+    {"savestate", "compact save states: round trips, size, save and restore cost", 20000, BenchSaveState},
+};
+
+#define BENCHMARK_COUNT (int)(sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static void PrintUsage(const char* program) {
+    printf("usage: %s [-n iterations] [--baseline file] [--save-baseline file] [--threshold percent]\n"
+           "       [--golden file] [--save-golden] [benchmark...]\n", program);
+    for (int i = 0; i < BENCHMARK_COUNT; i++) {
+        printf("  %-12s %s\n", benchmarks[i].name, benchmarks[i].description);
+    }
+}
+
+int main(int argc, char** argv) {
+    long iterations = 0; // 0 selects each benchmark's default
+    const char* selected[BENCHMARK_COUNT + 1];
+    int selectedCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--save-baseline") == 0 && i + 1 < argc) {
+            saveBaselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            regressionThreshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            goldenPath = argv[++i];
+        } else if (strcmp(argv[i], "--save-golden") == 0) {
+            saveGolden = true;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (selectedCount < BENCHMARK_COUNT) {
+            selected[selectedCount++] = argv[i];
+        }
+    }
+
+    if (iterations < 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    int ran = 0;
+    int failed = 0;
+    for (int i = 0; i < BENCHMARK_COUNT; i++) {
+        bool wanted = selectedCount == 0;
+        for (int j = 0; j < selectedCount; j++) {
+            if (strcmp(selected[j], benchmarks[i].name) == 0) {
+                wanted = true;
+            }
+        }
+        if (wanted) {
+            long count = iterations > 0 ? iterations : benchmarks[i].defaultIterations;
+            if (!benchmarks[i].run(count)) {
+                failed++;
+            }
+            ran++;
+        }
+    }
+
+    if (ran == 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
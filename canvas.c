@@ -0,0 +1,46 @@
+#include "canvas.h"
+
+// Software backend, straight onto the framebuffer primitives
+static void SoftwareFillRectangle(Canvas* canvas, int left, int top, int right, int bottom, uint32_t color) {
+    UseCanvasColor(canvas, color);
+    FillRectangle(canvas->surface, left, top, right, bottom, color);
+}
+
+static void SoftwareFillEllipse(Canvas* canvas, int left, int top, int right, int bottom, uint32_t color) {
+    UseCanvasColor(canvas, color);
+    FillEllipse(canvas->surface, left, top, right, bottom, color);
+}
+
+static void SoftwareFillPolygon(Canvas* canvas, const int* points, int count, uint32_t color) {
+    UseCanvasColor(canvas, color);
+    FillPolygon(canvas->surface, points, count, color);
+}
+
+static void SoftwareDrawLine(Canvas* canvas, int x0, int y0, int x1, int y1, uint32_t color) {
+    UseCanvasColor(canvas, color);
+    DrawLine(canvas->surface, x0, y0, x1, y1, color);
+}
+
+static void SoftwareDrawSprite(Canvas* canvas, SpriteId sprite, int x, int y) {
+    canvas->primitives++;
+    BlitSprite(canvas->surface, canvas->atlas, sprite, x, y);
+}
+
+const CanvasBackend softwareCanvas = {
+    SoftwareFillRectangle,
+    SoftwareFillEllipse,
+    SoftwareFillPolygon,
+    SoftwareDrawLine,
+    SoftwareDrawSprite,
+    NULL
+};
+
+void InitCanvas(Canvas* canvas, const CanvasBackend* backend, void* surface, const SpriteAtlas* atlas) {
+    canvas->backend = backend;
+    canvas->surface = surface;
+    canvas->atlas = atlas;
+    canvas->color = 0;
+    canvas->colorSet = false;
+    canvas->primitives = 0;
+    canvas->stateChanges = 0;
+}
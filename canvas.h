@@ -0,0 +1,66 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "framebuffer.h"
+#include "sprites.h"
+
+typedef struct Canvas Canvas;
+
+// Backend hooks: the drawing calls the scene is made of. Colors are FB_RGB,
+// rectangles and ellipses are [left, right) x [top, bottom) and polygons
+// are x, y pairs, like the framebuffer primitives.
+typedef struct {
+    void (*fillRectangle)(Canvas* canvas, int left, int top, int right, int bottom, uint32_t color);
+    void (*fillEllipse)(Canvas* canvas, int left, int top, int right, int bottom, uint32_t color);
+    void (*fillPolygon)(Canvas* canvas, const int* points, int count, uint32_t color);
+    void (*drawLine)(Canvas* canvas, int x0, int y0, int x1, int y1, uint32_t color);
+    void (*drawSprite)(Canvas* canvas, SpriteId sprite, int x, int y);
+
+    // Optional: the primitives that follow, up to the next layer, may be
+    // drawn in any order among themselves because none of them overlap or
+    // their overlap does not matter. NULL for backends that draw at once.
+    void (*beginLayer)(Canvas* canvas, bool reorderable);
+} CanvasBackend;
+
+// Where the scene is drawn: a GDI device context in the window, or a
+// framebuffer through the software rasterizer on any platform
+struct Canvas {
+    const CanvasBackend* backend;
+    void* surface;             // HDC for GDI, Framebuffer* for software
+    const SpriteAtlas* atlas;  // sprite pixels for the software backend
+
+    // Drawing state, kept by the backends through UseCanvasColor
+    uint32_t color;            // last color set, valid once colorSet
+    bool colorSet;
+    long primitives;           // since InitCanvas
+    long stateChanges;         // color changes since InitCanvas
+};
+
+// Backend that draws into a Framebuffer, available on every platform
+extern const CanvasBackend softwareCanvas;
+
+void InitCanvas(Canvas* canvas, const CanvasBackend* backend, void* surface, const SpriteAtlas* atlas);
+
+// Count a primitive drawn in a color, true when the backend has to switch
+// to that color first
+static inline bool UseCanvasColor(Canvas* canvas, uint32_t color) {
+    canvas->primitives++;
+    if (canvas->colorSet && canvas->color == color) {
+        return false;
+    }
+    canvas->color = color;
+    canvas->colorSet = true;
+    canvas->stateChanges++;
+    return true;
+}
+
+static inline void BeginCanvasLayer(Canvas* canvas, bool reorderable) {
+    if (canvas->backend->beginLayer != NULL) {
+        canvas->backend->beginLayer(canvas, reorderable);
+    }
+}
+
+#endif
@@ -0,0 +1,387 @@
+#include "collision.h"
+#include "particles.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Cells covering the whole world
+bool CreateCollisionGrid(CollisionGrid* grid, int worldWidth, int worldHeight) {
+    grid->cols = (worldWidth + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+    grid->rows = (worldHeight + GRID_CELL_SIZE - 1) / GRID_CELL_SIZE;
+    grid->cells = calloc((size_t)grid->cols * grid->rows, sizeof(uint32_t));
+    for (int target = 0; target < GRID_TARGET_COUNT; target++) {
+        grid->spans[target] = (GridSpan){0, -1, 0, -1};
+    }
+    return grid->cells != NULL;
+}
+
+void DestroyCollisionGrid(CollisionGrid* grid) {
+    free(grid->cells);
+    grid->cells = NULL;
+}
+
+static int ClampCell(int value, int cells) {
+    int cell = value < 0 ? 0 : value / GRID_CELL_SIZE;
+    return cell < cells ? cell : cells - 1;
+}
+
+// Cells overlapping [left, right] x [top, bottom], edges included
+static GridSpan BoxSpan(const CollisionGrid* grid, int left, int top, int right, int bottom) {
+    GridSpan span = {ClampCell(left, grid->cols), ClampCell(right, grid->cols),
+                     ClampCell(top, grid->rows), ClampCell(bottom, grid->rows)};
+    return span;
+}
+
+// Keep the bits of keep and add those of set in every cell of span
+static void MarkSpan(CollisionGrid* grid, GridSpan span, uint32_t set, uint32_t keep) {
+    for (int row = span.row0; row <= span.row1; row++) {
+        uint32_t* cells = grid->cells + (size_t)row * grid->cols;
+        for (int col = span.col0; col <= span.col1; col++) {
+            cells[col] = (cells[col] & keep) | set;
+        }
+    }
+}
+
+// Move a target's bit to the cells of span, touching nothing if they are
+// the ones it already has
+static void PlaceTarget(CollisionGrid* grid, int target, GridSpan span) {
+    GridSpan* placed = &grid->spans[target];
+    if (memcmp(placed, &span, sizeof(span)) == 0) {
+        return;
+    }
+    uint32_t bit = 1u << target;
+    MarkSpan(grid, *placed, 0, ~bit);
+    MarkSpan(grid, span, bit, ~0u);
+    *placed = span;
+}
+
+// Updated in place every tick: each target keeps the span it was placed
+// in, and only a target whose box now covers other cells is cleared from
+// the old ones and set in the new. A shield's box stays put as its blocks
+// are shot away, and the formation and the player change cells every few
+// steps, so most ticks touch no cell at all, however large the formation.
+void BuildCollisionGrid(CollisionGrid* grid, const Game* game) {
+    for (int s = 0; s < MAX_SHIELDS; s++) {
+        const Shield* shield = &game->shields[s];
+        GridSpan span = {0, -1, 0, -1};
+        if (s < game->config.shieldCount) {
+            span = BoxSpan(grid, shield->x, shield->y, shield->x + SHIELD_WIDTH, shield->y + SHIELD_HEIGHT);
+        }
+        PlaceTarget(grid, s, span);
+    }
+
+    // Live columns across, from the top row down to the lowest live row
+    const Formation* formation = &game->formation;
+    GridSpan span = {0, -1, 0, -1};
+    if (formation->liveCount > 0) {
+        span = BoxSpan(grid, AlienX(formation, formation->minCol), AlienY(formation, 0),
+                       AlienX(formation, formation->maxCol) + formation->width,
+                       AlienY(formation, formation->lowestLiveRow) + formation->height);
+    }
+    PlaceTarget(grid, MAX_SHIELDS, span);
+
+    PlaceTarget(grid, MAX_SHIELDS + 1, BoxSpan(grid, game->playerX, game->playerY,
+                                               game->playerX + PLAYER_WIDTH, game->playerY + PLAYER_HEIGHT));
+}
+
+// Targets that may overlap the box
+unsigned QueryCollisionGrid(const CollisionGrid* grid, int left, int top, int right, int bottom) {
+    int col0 = ClampCell(left, grid->cols);
+    int col1 = ClampCell(right, grid->cols);
+    int row0 = ClampCell(top, grid->rows);
+    int row1 = ClampCell(bottom, grid->rows);
+
+    unsigned targets = 0;
+    for (int row = row0; row <= row1; row++) {
+        const uint32_t* cells = grid->cells + (size_t)row * grid->cols;
+        for (int col = col0; col <= col1; col++) {
+            targets |= cells[col];
+        }
+    }
+    return targets;
+}
+
+// Slab test: earliest time in [0, 1] at which the segment from (x0, y0) to
+// (x1, y1) touches the box [left, right] x [top, bottom], edges included
+bool SweepBox(int x0, int y0, int x1, int y1, int left, int top, int right, int bottom, double* time) {
+    double enter = 0.0, leave = 1.0;
+    int starts[2] = {x0, y0};
+    int deltas[2] = {x1 - x0, y1 - y0};
+    int lows[2] = {left, top};
+    int highs[2] = {right, bottom};
+
+    for (int axis = 0; axis < 2; axis++) {
+        if (deltas[axis] == 0) {
+            if (starts[axis] < lows[axis] || starts[axis] > highs[axis]) {
+                return false;
+            }
+            continue;
+        }
+        double t0 = (double)(lows[axis] - starts[axis]) / deltas[axis];
+        double t1 = (double)(highs[axis] - starts[axis]) / deltas[axis];
+        if (t0 > t1) {
+            double swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        if (t0 > enter) enter = t0;
+        if (t1 < leave) leave = t1;
+        if (enter > leave) {
+            return false;
+        }
+    }
+    *time = enter;
+    return true;
+}
+
+// Bounding box of a bullet's path this tick
+typedef struct {
+    int left, top, right, bottom;
+} PathBounds;
+
+static PathBounds BulletPathBounds(const Bullet* bullet) {
+    PathBounds bounds;
+    bounds.left = bullet->prevX < bullet->x ? bullet->prevX : bullet->x;
+    bounds.right = bullet->prevX < bullet->x ? bullet->x : bullet->prevX;
+    bounds.top = bullet->prevY < bullet->y ? bullet->prevY : bullet->y;
+    bounds.bottom = bullet->prevY < bullet->y ? bullet->y : bullet->prevY;
+    return bounds;
+}
+
+// First live alien along the path; ties go to the first in row-major order
+static bool SweepFormation(const Formation* formation, const Bullet* bullet, const PathBounds* bounds,
+                           int* hitRow, int* hitCol, double* hitTime) {
+    int firstRow, lastRow, firstCol, lastCol;
+    FormationCellRange(formation, bounds->left, bounds->top, bounds->right, bounds->bottom,
+                       &firstRow, &lastRow, &firstCol, &lastCol);
+
+    bool found = false;
+    for (int row = firstRow; row <= lastRow; row++) {
+        int y = AlienY(formation, row);
+        for (int col = firstCol; col <= lastCol; col++) {
+            int x = AlienX(formation, col);
+            double time;
+            if (IsAlienAlive(formation, row, col) &&
+                SweepBox(bullet->prevX, bullet->prevY, bullet->x, bullet->y,
+                         x, y, x + formation->width, y + formation->height, &time) &&
+                (!found || time < *hitTime)) {
+                found = true;
+                *hitRow = row;
+                *hitCol = col;
+                *hitTime = time;
+            }
+        }
+    }
+    return found;
+}
+
+// Shield blocks the path can touch. The ranges may include one block too
+// many on the low side, the exact test sorts that out.
+static void ShieldBlockRange(const Shield* shield, const PathBounds* bounds,
+                             int* firstRow, int* lastRow, int* firstCol, int* lastCol) {
+    *firstCol = (bounds->left - shield->x - SHIELD_BLOCK_SIZE) / SHIELD_BLOCK_SIZE;
+    *lastCol = (bounds->right - shield->x) / SHIELD_BLOCK_SIZE;
+    *firstRow = (bounds->top - shield->y - SHIELD_BLOCK_SIZE) / SHIELD_BLOCK_SIZE;
+    *lastRow = (bounds->bottom - shield->y) / SHIELD_BLOCK_SIZE;
+    if (*firstCol < 0) *firstCol = 0;
+    if (*firstRow < 0) *firstRow = 0;
+    if (*lastCol >= SHIELD_COLS) *lastCol = SHIELD_COLS - 1;
+    if (*lastRow >= SHIELD_ROWS) *lastRow = SHIELD_ROWS - 1;
+}
+
+// Time at which the path first touches an active block of the shield, and
+// which blocks it touches at that moment (one row mask per block row). A
+// bullet running exactly along a block edge touches two blocks at once.
+static bool SweepShield(const Shield* shield, const Bullet* bullet, const PathBounds* bounds,
+                        uint16_t* struck, double* hitTime) {
+    int firstRow, lastRow, firstCol, lastCol;
+    ShieldBlockRange(shield, bounds, &firstRow, &lastRow, &firstCol, &lastCol);
+
+    bool found = false;
+    for (int row = firstRow; row <= lastRow; row++) {
+        int blockY = shield->y + row * SHIELD_BLOCK_SIZE;
+        for (int col = firstCol; col <= lastCol; col++) {
+            int blockX = shield->x + col * SHIELD_BLOCK_SIZE;
+            double time;
+            if (!IsShieldBlockActive(shield, col, row) ||
+                !SweepBox(bullet->prevX, bullet->prevY, bullet->x, bullet->y,
+                          blockX, blockY, blockX + SHIELD_BLOCK_SIZE, blockY + SHIELD_BLOCK_SIZE, &time)) {
+                continue;
+            }
+            if (!found || time < *hitTime) {
+                memset(struck, 0, sizeof(uint16_t) * SHIELD_ROWS);
+                found = true;
+                *hitTime = time;
+            }
+            if (time == *hitTime) {
+                struck[row] |= (uint16_t)(1u << col);
+            }
+        }
+    }
+    return found;
+}
+
+// Earliest shield hit among the candidate shields; ties go to the lowest index
+static int SweepShields(const Game* game, unsigned shields, const Bullet* bullet, const PathBounds* bounds,
+                        uint16_t* struck, double* hitTime) {
+    int hitShield = -1;
+    for (; shields != 0; shields &= shields - 1) {
+        int s = LowestBit(shields);
+        uint16_t blocks[SHIELD_ROWS];
+        double time;
+        if (SweepShield(&game->shields[s], bullet, bounds, blocks, &time) &&
+            (hitShield < 0 || time < *hitTime)) {
+            hitShield = s;
+            *hitTime = time;
+            memcpy(struck, blocks, sizeof(blocks));
+        }
+    }
+    return hitShield;
+}
+
+static void StrikeShield(Shield* shield, const uint16_t* struck) {
+    for (int row = 0; row < SHIELD_ROWS; row++) {
+        shield->rows[row] &= (uint16_t)~struck[row];
+    }
+}
+
+// Player bullets vs aliens and shields. On a tie the alien is hit, as the
+// aliens have always been checked before the shields.
+void CollidePlayerBullets(Game* game, const CollisionGrid* grid, Bullet* bullets, int count) {
+    Formation* formation = &game->formation;
+    for (int i = 0; i < count; i++) {
+        Bullet* bullet = &bullets[i];
+        if (!bullet->active) {
+            continue;
+        }
+        PathBounds bounds = BulletPathBounds(bullet);
+        unsigned targets = QueryCollisionGrid(grid, bounds.left, bounds.top, bounds.right, bounds.bottom);
+
+        int row = -1, col = -1;
+        double alienTime = 0.0;
+        bool alienHit = (targets & GRID_TARGET_FORMATION) &&
+                        SweepFormation(formation, bullet, &bounds, &row, &col, &alienTime);
+
+        uint16_t struck[SHIELD_ROWS];
+        double shieldTime = 0.0;
+        int shield = SweepShields(game, targets & GRID_TARGET_SHIELDS, bullet, &bounds, struck, &shieldTime);
+
+        if (alienHit && (shield < 0 || alienTime <= shieldTime)) {
+            // Hit alien
+            KillAlien(formation, row, col);
+            bullet->active = false;
+
+            // Add score based on alien type
+            switch (formation->rowType[row]) {
+                case 0: game->score += 30; break;
+                case 1: game->score += 20; break;
+                case 2: game->score += 10; break;
+            }
+
+            // Create explosion
+            CreateExplosion(game, AlienX(formation, col) + formation->width / 2,
+                            AlienY(formation, row) + formation->height / 2);
+        } else if (shield >= 0) {
+            // Hit shield
+            StrikeShield(&game->shields[shield], struck);
+            bullet->active = false;
+            SpawnDebris(game->particles, bullet->x, bullet->y);
+        }
+    }
+}
+
+// Alien bullets vs the player and shields. The player can only be hit once
+// per tick; later bullets go on to the shields.
+void CollideAlienBullets(Game* game, const CollisionGrid* grid, Bullet* bullets, int count) {
+    bool playerHit = false;
+    for (int i = 0; i < count; i++) {
+        Bullet* bullet = &bullets[i];
+        if (!bullet->active) {
+            continue;
+        }
+        PathBounds bounds = BulletPathBounds(bullet);
+        unsigned targets = QueryCollisionGrid(grid, bounds.left, bounds.top, bounds.right, bounds.bottom);
+
+        double playerTime = 0.0;
+        bool hitsPlayer = !playerHit && (targets & GRID_TARGET_PLAYER) &&
+                          SweepBox(bullet->prevX, bullet->prevY, bullet->x, bullet->y,
+                                   game->playerX, game->playerY,
+                                   game->playerX + PLAYER_WIDTH, game->playerY + PLAYER_HEIGHT, &playerTime);
+
+        uint16_t struck[SHIELD_ROWS];
+        double shieldTime = 0.0;
+        int shield = SweepShields(game, targets & GRID_TARGET_SHIELDS, bullet, &bounds, struck, &shieldTime);
+
+        if (hitsPlayer && (shield < 0 || playerTime <= shieldTime)) {
+            // Hit player
+            bullet->active = false;
+            playerHit = true;
+            game->playerLives--;
+
+            // Create explosion
+            CreateExplosion(game, game->playerX + PLAYER_WIDTH / 2, game->playerY + PLAYER_HEIGHT / 2);
+
+            // Check game over
+            if (game->playerLives <= 0) {
+                game->state = GAME_OVER;
+                game->gameOverTimer = 0;
+            }
+        } else if (shield >= 0) {
+            // Hit shield
+            StrikeShield(&game->shields[shield], struck);
+            bullet->active = false;
+            SpawnDebris(game->particles, bullet->x, bullet->y);
+        }
+    }
+}
+
+// Ticks before a bullet moving speed per tick gets to a point time of the
+// way along a path of ticks ticks. The tick that reaches it may take it
+// exactly, so one fewer is left.
+static int TicksBefore(double time, int ticks) {
+    int before = (int)(time * ticks) - 1;
+    return before > 0 ? before : 0;
+}
+
+// How many of the coming ticks, at most limit, no bullet can touch
+// anything in, with the targets as they are. Each bullet sweeps the path
+// it would fly over that many ticks; shots fired meanwhile are not known
+// and are the caller's business.
+int QuietBulletTicks(const Game* game, const CollisionGrid* grid, int limit) {
+    int quiet = limit;
+    for (int i = 0; i < game->playerBulletPool.count && quiet > 0; i++) {
+        const Bullet* bullet = &game->playerBullets[i];
+        Bullet path = {bullet->x, bullet->y - game->config.playerBulletSpeed * quiet, bullet->x, bullet->y, true};
+        PathBounds bounds = BulletPathBounds(&path);
+        unsigned targets = QueryCollisionGrid(grid, bounds.left, bounds.top, bounds.right, bounds.bottom);
+
+        int row, col;
+        double time;
+        if ((targets & GRID_TARGET_FORMATION) &&
+            SweepFormation(&game->formation, &path, &bounds, &row, &col, &time)) {
+            quiet = TicksBefore(time, quiet);
+        }
+        uint16_t struck[SHIELD_ROWS];
+        if (quiet > 0 && SweepShields(game, targets & GRID_TARGET_SHIELDS, &path, &bounds, struck, &time) >= 0) {
+            quiet = TicksBefore(time, quiet);
+        }
+    }
+    for (int i = 0; i < game->alienBulletPool.count && quiet > 0; i++) {
+        const Bullet* bullet = &game->alienBullets[i];
+        Bullet path = {bullet->x, bullet->y + game->config.alienBulletSpeed * quiet, bullet->x, bullet->y, true};
+        PathBounds bounds = BulletPathBounds(&path);
+        unsigned targets = QueryCollisionGrid(grid, bounds.left, bounds.top, bounds.right, bounds.bottom);
+
+        double time;
+        if ((targets & GRID_TARGET_PLAYER) &&
+            SweepBox(path.prevX, path.prevY, path.x, path.y, game->playerX, game->playerY,
+                     game->playerX + PLAYER_WIDTH, game->playerY + PLAYER_HEIGHT, &time)) {
+            quiet = TicksBefore(time, quiet);
+        }
+        uint16_t struck[SHIELD_ROWS];
+        if (quiet > 0 && SweepShields(game, targets & GRID_TARGET_SHIELDS, &path, &bounds, struck, &time) >= 0) {
+            quiet = TicksBefore(time, quiet);
+        }
+    }
+    return quiet;
+}
@@ -0,0 +1,52 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// Uniform-grid broadphase over the world. Each cell holds a bitmask of
+// the collision targets whose box overlaps it, so a bullet only runs the
+// exact tests for the targets of the cells its path crosses. Points and
+// boxes outside the world are clamped to the border cells, which keeps
+// every overlap.
+#define GRID_CELL_SIZE 32
+
+// Target bits: one per shield, then the formation and the player
+#define GRID_TARGET_SHIELD(s) (1u << (s))
+#define GRID_TARGET_SHIELDS (GRID_TARGET_FORMATION - 1)
+#define GRID_TARGET_FORMATION (1u << MAX_SHIELDS)
+#define GRID_TARGET_PLAYER (1u << (MAX_SHIELDS + 1))
+#define GRID_TARGET_COUNT (MAX_SHIELDS + 2)
+
+// Cells [col0, col1] x [row0, row1] a target's bit is set in, empty when
+// row0 > row1
+typedef struct {
+    int col0, col1, row0, row1;
+} GridSpan;
+
+// Declared in game.h, which owns one per game
+struct CollisionGrid {
+    int cols, rows;
+    uint32_t* cells;                   // rows * cols, row-major
+    GridSpan spans[GRID_TARGET_COUNT]; // by target bit
+};
+
+bool CreateCollisionGrid(CollisionGrid* grid, int worldWidth, int worldHeight);
+void DestroyCollisionGrid(CollisionGrid* grid);
+void BuildCollisionGrid(CollisionGrid* grid, const Game* game);
+unsigned QueryCollisionGrid(const CollisionGrid* grid, int left, int top, int right, int bottom);
+
+bool SweepBox(int x0, int y0, int x1, int y1, int left, int top, int right, int bottom, double* time);
+
+// Collision passes over the path each bullet travelled this tick, from
+// (prevX, prevY) to (x, y). A bullet stops at the first thing it touches.
+void CollidePlayerBullets(Game* game, const CollisionGrid* grid, Bullet* bullets, int count);
+void CollideAlienBullets(Game* game, const CollisionGrid* grid, Bullet* bullets, int count);
+
+// Coming ticks, at most limit, in which no bullet can touch anything, for
+// fast-forwarding through them; may come out short, never long
+int QuietBulletTicks(const Game* game, const CollisionGrid* grid, int limit);
+
+#endif
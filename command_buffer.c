@@ -0,0 +1,236 @@
+#include "command_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int CompareUnsigned(uint32_t a, uint32_t b) {
+    return (a > b) - (a < b);
+}
+
+static int CompareInt(int a, int b) {
+    return (a > b) - (a < b);
+}
+
+// Kind and color first so each color is one run, then rectangles by row
+// for the horizontal merge
+static int CompareRows(const void* a, const void* b) {
+    const RenderCommand* x = a;
+    const RenderCommand* y = b;
+    int order = CompareUnsigned(x->kind, y->kind);
+    if (order == 0) order = CompareUnsigned(x->color, y->color);
+    if (order == 0 && x->kind == COMMAND_RECTANGLE) {
+        order = CompareInt(x->coords[1], y->coords[1]);
+        if (order == 0) order = CompareInt(x->coords[0], y->coords[0]);
+    }
+    return order != 0 ? order : CompareUnsigned(x->sequence, y->sequence);
+}
+
+// Same runs, with rectangles by column for the vertical merge
+static int CompareColumns(const void* a, const void* b) {
+    const RenderCommand* x = a;
+    const RenderCommand* y = b;
+    int order = CompareUnsigned(x->kind, y->kind);
+    if (order == 0) order = CompareUnsigned(x->color, y->color);
+    if (order == 0 && x->kind == COMMAND_RECTANGLE) {
+        order = CompareInt(x->coords[0], y->coords[0]);
+        if (order == 0) order = CompareInt(x->coords[2], y->coords[2]);
+        if (order == 0) order = CompareInt(x->coords[1], y->coords[1]);
+    }
+    return order != 0 ? order : CompareUnsigned(x->sequence, y->sequence);
+}
+
+static bool CanMerge(const RenderCommand* last, const RenderCommand* next) {
+    return last->kind == COMMAND_RECTANGLE && next->kind == COMMAND_RECTANGLE && last->color == next->color;
+}
+
+// Sort one reorderable layer into color runs and join the rectangles that
+// continue each other along a row, then along a column. A merged rectangle
+// covers exactly the pixels of its parts, so nothing drawn changes.
+// Returns the number of commands left.
+static int SortLayer(RenderCommand* commands, int count) {
+    qsort(commands, (size_t)count, sizeof(RenderCommand), CompareRows);
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        RenderCommand* last = kept > 0 ? &commands[kept - 1] : NULL;
+        if (last != NULL && CanMerge(last, &commands[i]) && last->coords[1] == commands[i].coords[1] &&
+            last->coords[3] == commands[i].coords[3] && last->coords[2] == commands[i].coords[0]) {
+            last->coords[2] = commands[i].coords[2];
+        } else {
+            commands[kept++] = commands[i];
+        }
+    }
+    count = kept;
+
+    qsort(commands, (size_t)count, sizeof(RenderCommand), CompareColumns);
+    kept = 0;
+    for (int i = 0; i < count; i++) {
+        RenderCommand* last = kept > 0 ? &commands[kept - 1] : NULL;
+        if (last != NULL && CanMerge(last, &commands[i]) && last->coords[0] == commands[i].coords[0] &&
+            last->coords[2] == commands[i].coords[2] && last->coords[3] == commands[i].coords[1]) {
+            last->coords[3] = commands[i].coords[3];
+        } else {
+            commands[kept++] = commands[i];
+        }
+    }
+    return kept;
+}
+
+// Commands are recorded layer after layer, so each layer is one stretch of
+// the buffer. Reorderable ones are sorted in place and closed up.
+static void SortLayers(CommandBuffer* buffer) {
+    RenderCommand* commands = buffer->commands;
+    int count = 0;
+    int begin = 0;
+    while (begin < buffer->count) {
+        int end = begin + 1;
+        while (end < buffer->count && commands[end].layer == commands[begin].layer) {
+            end++;
+        }
+        int kept = end - begin;
+        if (commands[begin].reorderable && kept > 1) {
+            kept = SortLayer(&commands[begin], kept);
+        }
+        memmove(&commands[count], &commands[begin], sizeof(RenderCommand) * (size_t)kept);
+        count += kept;
+        begin = end;
+    }
+    buffer->count = count;
+}
+
+static void Execute(CommandBuffer* buffer, const RenderCommand* command) {
+    Canvas* target = buffer->target;
+    const CanvasBackend* backend = target->backend;
+    const int* c = command->coords;
+    switch (command->kind) {
+        case COMMAND_RECTANGLE:
+            backend->fillRectangle(target, c[0], c[1], c[2], c[3], command->color);
+            break;
+        case COMMAND_ELLIPSE:
+            backend->fillEllipse(target, c[0], c[1], c[2], c[3], command->color);
+            break;
+        case COMMAND_POLYGON:
+            backend->fillPolygon(target, &buffer->points[c[0]], c[1], command->color);
+            break;
+        case COMMAND_LINE:
+            backend->drawLine(target, c[0], c[1], c[2], c[3], command->color);
+            break;
+        case COMMAND_SPRITE:
+            backend->drawSprite(target, (SpriteId)command->color, c[0], c[1]);
+            break;
+    }
+}
+
+void FlushCommands(CommandBuffer* buffer) {
+    SortLayers(buffer);
+    for (int i = 0; i < buffer->count; i++) {
+        Execute(buffer, &buffer->commands[i]);
+    }
+    buffer->executed += buffer->count;
+    buffer->count = 0;
+    buffer->pointCount = 0;
+    buffer->layer = 0;
+}
+
+// Next free command, flushing first when the buffer is full
+static RenderCommand* Record(CommandBuffer* buffer, CommandKind kind, uint32_t color) {
+    if (buffer->count == buffer->capacity) {
+        FlushCommands(buffer);
+    }
+    RenderCommand* command = &buffer->commands[buffer->count++];
+    command->sequence = buffer->sequence++;
+    command->layer = buffer->layer;
+    command->kind = (uint8_t)kind;
+    command->reorderable = buffer->reorderable;
+    command->color = color;
+    buffer->recorded++;
+    return command;
+}
+
+static void RecordFour(Canvas* canvas, CommandKind kind, int a, int b, int c, int d, uint32_t color) {
+    RenderCommand* command = Record(canvas->surface, kind, color);
+    command->coords[0] = a;
+    command->coords[1] = b;
+    command->coords[2] = c;
+    command->coords[3] = d;
+}
+
+static void CommandFillRectangle(Canvas* canvas, int left, int top, int right, int bottom, uint32_t color) {
+    RecordFour(canvas, COMMAND_RECTANGLE, left, top, right, bottom, color);
+}
+
+static void CommandFillEllipse(Canvas* canvas, int left, int top, int right, int bottom, uint32_t color) {
+    RecordFour(canvas, COMMAND_ELLIPSE, left, top, right, bottom, color);
+}
+
+static void CommandDrawLine(Canvas* canvas, int x0, int y0, int x1, int y1, uint32_t color) {
+    RecordFour(canvas, COMMAND_LINE, x0, y0, x1, y1, color);
+}
+
+static void CommandDrawSprite(Canvas* canvas, SpriteId sprite, int x, int y) {
+    RecordFour(canvas, COMMAND_SPRITE, x, y, 0, 0, (uint32_t)sprite);
+}
+
+static void CommandFillPolygon(Canvas* canvas, const int* points, int count, uint32_t color) {
+    CommandBuffer* buffer = canvas->surface;
+    int values = count * 2;
+    if (buffer->pointCount + values > buffer->pointCapacity) {
+        FlushCommands(buffer);
+        if (values > buffer->pointCapacity) {
+            buffer->recorded++;
+            buffer->executed++;
+            buffer->target->backend->fillPolygon(buffer->target, points, count, color);
+            return;
+        }
+    }
+    memcpy(&buffer->points[buffer->pointCount], points, sizeof(int) * (size_t)values);
+    RecordFour(canvas, COMMAND_POLYGON, buffer->pointCount, count, 0, 0, color);
+    buffer->pointCount += values;
+}
+
+static void CommandBeginLayer(Canvas* canvas, bool reorderable) {
+    CommandBuffer* buffer = canvas->surface;
+    if (buffer->layer == UINT16_MAX) {
+        FlushCommands(buffer);
+    }
+    buffer->layer++;
+    buffer->reorderable = reorderable;
+}
+
+const CanvasBackend commandCanvas = {
+    CommandFillRectangle,
+    CommandFillEllipse,
+    CommandFillPolygon,
+    CommandDrawLine,
+    CommandDrawSprite,
+    CommandBeginLayer
+};
+
+bool CreateCommandBuffer(CommandBuffer* buffer, int capacity, int pointCapacity) {
+    memset(buffer, 0, sizeof(CommandBuffer));
+    buffer->commands = malloc(sizeof(RenderCommand) * (size_t)capacity);
+    buffer->points = malloc(sizeof(int) * (size_t)pointCapacity);
+    if (buffer->commands == NULL || buffer->points == NULL) {
+        DestroyCommandBuffer(buffer);
+        return false;
+    }
+    buffer->capacity = capacity;
+    buffer->pointCapacity = pointCapacity;
+    return true;
+}
+
+void DestroyCommandBuffer(CommandBuffer* buffer) {
+    free(buffer->commands);
+    free(buffer->points);
+    memset(buffer, 0, sizeof(CommandBuffer));
+}
+
+void BeginCommands(CommandBuffer* buffer, Canvas* target) {
+    buffer->target = target;
+    buffer->count = 0;
+    buffer->pointCount = 0;
+    buffer->sequence = 0;
+    buffer->layer = 0;
+    buffer->reorderable = false;
+    buffer->recorded = 0;
+    buffer->executed = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "canvas.h"
+
+// Room for a full particle system plus the rest of the playfield
+#define DEFAULT_COMMAND_CAPACITY 32768
+#define DEFAULT_COMMAND_POINTS 16384
+
+typedef enum {
+    COMMAND_RECTANGLE,
+    COMMAND_ELLIPSE,
+    COMMAND_POLYGON,
+    COMMAND_LINE,
+    COMMAND_SPRITE
+} CommandKind;
+
+// One recorded drawing call. Rectangles and ellipses keep left, top, right,
+// bottom, lines x0, y0, x1, y1, sprites x, y and polygons the offset and
+// count of their points in the buffer.
+typedef struct {
+    uint32_t sequence;    // recording order
+    uint16_t layer;
+    uint8_t kind;         // CommandKind
+    uint8_t reorderable;  // from BeginCanvasLayer
+    uint32_t color;       // FB_RGB, or the SpriteId of a sprite
+    int coords[4];
+} RenderCommand;
+
+// Drawing calls recorded through commandCanvas and replayed onto a target
+// canvas by FlushCommands. Within a reorderable layer the calls are sorted
+// by kind and color so the target switches state once per color, and
+// rectangles of one color that touch edge to edge, like the shield blocks,
+// are merged into spans first. Layers themselves always keep their order.
+//
+// The arrays are allocated once; running out of room flushes early.
+typedef struct {
+    RenderCommand* commands;
+    int count, capacity;
+    int* points;
+    int pointCount, pointCapacity;
+    Canvas* target;
+    uint32_t sequence;
+    uint16_t layer;
+    bool reorderable;
+    long recorded;  // since BeginCommands
+    long executed;  // after merging, since BeginCommands
+} CommandBuffer;
+
+// Backend whose surface is a CommandBuffer
+extern const CanvasBackend commandCanvas;
+
+bool CreateCommandBuffer(CommandBuffer* buffer, int capacity, int pointCapacity);
+void DestroyCommandBuffer(CommandBuffer* buffer);
+
+// Start recording for the target, clearing the counters
+void BeginCommands(CommandBuffer* buffer, Canvas* target);
+
+// Sort, merge and draw everything recorded onto the target, then empty the
+// buffer
+void FlushCommands(CommandBuffer* buffer);
+
+#endif
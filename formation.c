@@ -0,0 +1,211 @@
+#include "formation.h"
+
+#include <string.h>
+
+// Integer division rounding toward negative infinity
+static int FloorDiv(int a, int b) {
+    int q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) {
+        q--;
+    }
+    return q;
+}
+
+// Highest set bit of a multi-word mask, -1 when it is empty
+static int HighestBitOf(const uint64_t* words, int count) {
+    for (int w = count - 1; w >= 0; w--) {
+        if (words[w] != 0) {
+            return w * 64 + HighestBit(words[w]);
+        }
+    }
+    return -1;
+}
+
+// Lowest set bit of a multi-word mask, -1 when it is empty
+static int LowestBitOf(const uint64_t* words, int count) {
+    for (int w = 0; w < count; w++) {
+        if (words[w] != 0) {
+            return w * 64 + LowestBit(words[w]);
+        }
+    }
+    return -1;
+}
+
+// First `bits` bits set
+static void FillMask(uint64_t* words, int count, int bits) {
+    for (int w = 0; w < count; w++) {
+        int remaining = bits - w * 64;
+        words[w] = remaining >= 64 ? ~0ULL : (remaining > 0 ? (1ULL << remaining) - 1 : 0);
+    }
+}
+
+// The top fifth of the rows are type 0, the next two fifths type 1 and the
+// rest type 2 (1, 2 and 2 rows for 5x11)
+static uint8_t RowType(int row, int rows) {
+    return row < rows / 5 ? 0 : (row < rows * 3 / 5 ? 1 : 2);
+}
+
+// Fill a formation with live aliens
+void InitFormation(Formation* formation, int rows, int cols, int originX, int originY,
+                   int pitchX, int pitchY, int width, int height) {
+    if (rows > FORMATION_MAX_ROWS) rows = FORMATION_MAX_ROWS;
+    if (cols > FORMATION_MAX_COLS) cols = FORMATION_MAX_COLS;
+
+    formation->rows = rows;
+    formation->cols = cols;
+    formation->originX = originX;
+    formation->originY = originY;
+    formation->pitchX = pitchX;
+    formation->pitchY = pitchY;
+    formation->width = width;
+    formation->height = height;
+    formation->liveCount = rows * cols;
+
+    memset(formation->alive, 0, sizeof(formation->alive));
+    memset(formation->columnAlive, 0, sizeof(formation->columnAlive));
+    for (int row = 0; row < rows; row++) {
+        formation->rowType[row] = RowType(row, rows);
+        formation->rowCount[row] = (int16_t)cols;
+        FillMask(formation->alive[row], FORMATION_ROW_WORDS, cols);
+    }
+    for (int col = 0; col < cols; col++) {
+        formation->columnCount[col] = (int16_t)rows;
+        formation->lowestRow[col] = (int16_t)(rows - 1);
+        formation->liveColumns[col] = (int16_t)col;
+        formation->columnSlot[col] = (int16_t)col;
+        FillMask(formation->columnAlive[col], FORMATION_COL_WORDS, rows);
+    }
+    FillMask(formation->liveColumnMask, FORMATION_ROW_WORDS, cols);
+    FillMask(formation->liveRowMask, FORMATION_COL_WORDS, rows);
+    formation->liveColumnCount = cols;
+
+    bool empty = rows <= 0 || cols <= 0;
+    formation->minCol = empty ? -1 : 0;
+    formation->maxCol = empty ? -1 : cols - 1;
+    formation->lowestLiveRow = empty ? -1 : rows - 1;
+}
+
+// Remove a live alien and update the column and row bookkeeping
+void KillAlien(Formation* formation, int row, int col) {
+    formation->alive[row][col >> 6] &= ~(1ULL << (col & 63));
+    formation->columnAlive[col][row >> 6] &= ~(1ULL << (row & 63));
+    formation->liveCount--;
+
+    if (--formation->rowCount[row] == 0) {
+        formation->liveRowMask[row >> 6] &= ~(1ULL << (row & 63));
+        if (row == formation->lowestLiveRow) {
+            formation->lowestLiveRow = HighestBitOf(formation->liveRowMask, FORMATION_COL_WORDS);
+        }
+    }
+
+    if (--formation->columnCount[col] > 0) {
+        if (row == formation->lowestRow[col]) {
+            formation->lowestRow[col] = (int16_t)HighestBitOf(formation->columnAlive[col], FORMATION_COL_WORDS);
+        }
+        return;
+    }
+
+    // The column is empty: drop it from the live list and the extents
+    formation->lowestRow[col] = -1;
+    formation->liveColumnMask[col >> 6] &= ~(1ULL << (col & 63));
+    int slot = formation->columnSlot[col];
+    int last = formation->liveColumns[--formation->liveColumnCount];
+    formation->liveColumns[slot] = (int16_t)last;
+    formation->columnSlot[last] = (int16_t)slot;
+
+    if (col == formation->minCol) {
+        formation->minCol = LowestBitOf(formation->liveColumnMask, FORMATION_ROW_WORDS);
+    }
+    if (col == formation->maxCol) {
+        formation->maxCol = HighestBitOf(formation->liveColumnMask, FORMATION_ROW_WORDS);
+    }
+}
+
+// Rebuild the bookkeeping of a formation whose size, geometry and alive
+// flags were set directly, as a save state does. The live columns keep the
+// given order, which KillAlien produced and the shooter choice depends on;
+// false when that order does not list exactly the non-empty columns.
+bool RestoreFormation(Formation* formation, const int16_t* liveColumns, int liveColumnCount) {
+    int rows = formation->rows;
+    int cols = formation->cols;
+    if (rows < 0 || rows > FORMATION_MAX_ROWS || cols < 0 || cols > FORMATION_MAX_COLS) {
+        return false;
+    }
+
+    memset(formation->columnAlive, 0, sizeof(formation->columnAlive));
+    memset(formation->liveColumnMask, 0, sizeof(formation->liveColumnMask));
+    memset(formation->liveRowMask, 0, sizeof(formation->liveRowMask));
+    for (int col = 0; col < cols; col++) {
+        formation->columnCount[col] = 0;
+        formation->lowestRow[col] = -1;
+        formation->columnSlot[col] = -1;
+    }
+
+    // Rows from the top down, so the last row seen in a column is its lowest
+    formation->liveCount = 0;
+    for (int row = 0; row < rows; row++) {
+        int count = 0;
+        formation->rowType[row] = RowType(row, rows);
+        for (int w = 0; w < FORMATION_ROW_WORDS; w++) {
+            for (uint64_t bits = formation->alive[row][w]; bits != 0; bits &= bits - 1) {
+                int col = w * 64 + LowestBit(bits);
+                if (col >= cols) {
+                    return false;
+                }
+                formation->columnAlive[col][row >> 6] |= 1ULL << (row & 63);
+                formation->columnCount[col]++;
+                formation->lowestRow[col] = (int16_t)row;
+                count++;
+            }
+        }
+        formation->rowCount[row] = (int16_t)count;
+        if (count > 0) {
+            formation->liveRowMask[row >> 6] |= 1ULL << (row & 63);
+        }
+        formation->liveCount += count;
+    }
+
+    int nonEmpty = 0;
+    for (int col = 0; col < cols; col++) {
+        if (formation->columnCount[col] > 0) {
+            formation->liveColumnMask[col >> 6] |= 1ULL << (col & 63);
+            nonEmpty++;
+        }
+    }
+    if (liveColumnCount != nonEmpty) {
+        return false;
+    }
+    for (int slot = 0; slot < liveColumnCount; slot++) {
+        int col = liveColumns[slot];
+        if (col < 0 || col >= cols || formation->columnCount[col] == 0 || formation->columnSlot[col] >= 0) {
+            return false;
+        }
+        formation->liveColumns[slot] = (int16_t)col;
+        formation->columnSlot[col] = (int16_t)slot;
+    }
+    formation->liveColumnCount = liveColumnCount;
+
+    formation->minCol = LowestBitOf(formation->liveColumnMask, FORMATION_ROW_WORDS);
+    formation->maxCol = HighestBitOf(formation->liveColumnMask, FORMATION_ROW_WORDS);
+    formation->lowestLiveRow = HighestBitOf(formation->liveRowMask, FORMATION_COL_WORDS);
+    return true;
+}
+
+// Rows and columns whose aliens can overlap the box [left, right] x
+// [top, bottom] (edges included); the ranges are empty when none can
+void FormationCellRange(const Formation* formation, int left, int top, int right, int bottom,
+                        int* firstRow, int* lastRow, int* firstCol, int* lastCol) {
+    int localLeft = left - formation->originX;
+    int localTop = top - formation->originY;
+    int localRight = right - formation->originX;
+    int localBottom = bottom - formation->originY;
+
+    *firstRow = FloorDiv(localTop - formation->height + formation->pitchY - 1, formation->pitchY);
+    *lastRow = FloorDiv(localBottom, formation->pitchY);
+    *firstCol = FloorDiv(localLeft - formation->width + formation->pitchX - 1, formation->pitchX);
+    *lastCol = FloorDiv(localRight, formation->pitchX);
+    if (*firstRow < 0) *firstRow = 0;
+    if (*firstCol < 0) *firstCol = 0;
+    if (*lastRow >= formation->rows) *lastRow = formation->rows - 1;
+    if (*lastCol >= formation->cols) *lastCol = formation->cols - 1;
+}
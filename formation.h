@@ -0,0 +1,95 @@
+#ifndef FORMATION_H
+#define FORMATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Largest formation a game can hold; the classic one is 5x11
+#define FORMATION_MAX_ROWS 128
+#define FORMATION_MAX_COLS 128
+#define FORMATION_ROW_WORDS ((FORMATION_MAX_COLS + 63) / 64)
+#define FORMATION_COL_WORDS ((FORMATION_MAX_ROWS + 63) / 64)
+
+// Alien formation. The aliens always move together, so the formation is
+// one origin plus a fixed cell pitch; an alien's position is derived from
+// its row and column. Alive flags are packed 64 columns per word.
+//
+// KillAlien keeps per-column bookkeeping up to date so the edges of the
+// formation, its lowest row and the shooter of any column are known
+// without scanning.
+typedef struct {
+    int rows, cols;
+    int originX, originY; // top-left corner of the alien at row 0, column 0
+    int pitchX, pitchY;   // distance between neighbouring aliens
+    int width, height;    // size of one alien
+    int liveCount;
+    uint64_t alive[FORMATION_MAX_ROWS][FORMATION_ROW_WORDS];
+    uint8_t rowType[FORMATION_MAX_ROWS];
+
+    // Same alive flags by column (64 rows per word), and which rows and
+    // columns still have anyone in them
+    uint64_t columnAlive[FORMATION_MAX_COLS][FORMATION_COL_WORDS];
+    uint64_t liveColumnMask[FORMATION_ROW_WORDS];
+    uint64_t liveRowMask[FORMATION_COL_WORDS];
+    int16_t rowCount[FORMATION_MAX_ROWS];
+    int16_t columnCount[FORMATION_MAX_COLS];
+    int16_t lowestRow[FORMATION_MAX_COLS]; // lowest live row per column, -1 if empty
+
+    // Non-empty columns in no particular order, for picking one at random
+    int16_t liveColumns[FORMATION_MAX_COLS];
+    int16_t columnSlot[FORMATION_MAX_COLS]; // index in liveColumns
+    int liveColumnCount;
+
+    // Live extents, -1 when the formation is empty
+    int minCol, maxCol;
+    int lowestLiveRow;
+} Formation;
+
+void InitFormation(Formation* formation, int rows, int cols, int originX, int originY,
+                   int pitchX, int pitchY, int width, int height);
+void KillAlien(Formation* formation, int row, int col);
+bool RestoreFormation(Formation* formation, const int16_t* liveColumns, int liveColumnCount);
+void FormationCellRange(const Formation* formation, int left, int top, int right, int bottom,
+                        int* firstRow, int* lastRow, int* firstCol, int* lastCol);
+
+static inline bool IsAlienAlive(const Formation* formation, int row, int col) {
+    return (formation->alive[row][col >> 6] >> (col & 63)) & 1;
+}
+
+static inline int AlienX(const Formation* formation, int col) {
+    return formation->originX + col * formation->pitchX;
+}
+
+static inline int AlienY(const Formation* formation, int row) {
+    return formation->originY + row * formation->pitchY;
+}
+
+// Index of the lowest set bit, bits must not be zero
+static inline int LowestBit(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int index = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Index of the highest set bit, bits must not be zero
+static inline int HighestBit(uint64_t bits) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(bits);
+#else
+    int index = 63;
+    while (!(bits >> 63)) {
+        bits <<= 1;
+        index--;
+    }
+    return index;
+#endif
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include "framebuffer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Eight pixels in one vector. GCC and Clang lower it to whatever the target
+// has (two SSE2 stores, one AVX store, NEON pairs) and to scalar code
+// without vector units, so the span fill needs no per-ISA versions.
+#if defined(__GNUC__)
+#define FB_VECTOR_SPANS 1
+typedef uint32_t PixelVector __attribute__((vector_size(32)));
+#else
+#define FB_VECTOR_SPANS 0
+#endif
+
+// Set count pixels from row on, a vector at a time then the tail. memcpy
+// keeps the stores unaligned-safe and compiles to plain vector moves.
+static inline void FillSpan(uint32_t* row, int count, uint32_t color) {
+    int x = 0;
+#if FB_VECTOR_SPANS
+    PixelVector pixels = {color, color, color, color, color, color, color, color};
+    for (; x + 8 <= count; x += 8) {
+        memcpy(row + x, &pixels, sizeof(pixels));
+    }
+#endif
+    for (; x < count; x++) {
+        row[x] = color;
+    }
+}
+
+// Allocate a framebuffer
+bool CreateFramebuffer(Framebuffer* fb, int width, int height) {
+    fb->pixels = malloc((size_t)width * height * sizeof(uint32_t));
+    if (fb->pixels == NULL) {
+        fb->width = fb->height = fb->stride = 0;
+        return false;
+    }
+    fb->width = width;
+    fb->height = height;
+    fb->stride = width;
+    return true;
+}
+
+// Free a framebuffer
+void DestroyFramebuffer(Framebuffer* fb) {
+    free(fb->pixels);
+    fb->pixels = NULL;
+    fb->width = fb->height = fb->stride = 0;
+}
+
+// Fill the whole framebuffer with one color
+void ClearFramebuffer(Framebuffer* fb, uint32_t color) {
+    for (int y = 0; y < fb->height; y++) {
+        FillSpan(fb->pixels + (size_t)y * fb->stride, fb->width, color);
+    }
+}
+
+// Fill [left, right) x [top, bottom)
+void FillRectangle(Framebuffer* fb, int left, int top, int right, int bottom, uint32_t color) {
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    if (right > fb->width) right = fb->width;
+    if (bottom > fb->height) bottom = fb->height;
+    if (left >= right) {
+        return;
+    }
+
+    for (int y = top; y < bottom; y++) {
+        FillSpan(fb->pixels + (size_t)y * fb->stride + left, right - left, color);
+    }
+}
+
+// Fill the ellipse inscribed in [left, right) x [top, bottom), like GDI Ellipse
+void FillEllipse(Framebuffer* fb, int left, int top, int right, int bottom, uint32_t color) {
+    double radiusX = (right - left) / 2.0;
+    double radiusY = (bottom - top) / 2.0;
+    if (radiusX <= 0 || radiusY <= 0) {
+        return;
+    }
+    double centerX = (left + right) / 2.0;
+    double centerY = (top + bottom) / 2.0;
+
+    int y0 = top < 0 ? 0 : top;
+    int y1 = bottom > fb->height ? fb->height : bottom;
+    for (int y = y0; y < y1; y++) {
+        double dy = (y + 0.5 - centerY) / radiusY;
+        double span = radiusX * sqrt(1.0 - dy * dy);
+        int x0 = (int)ceil(centerX - span - 0.5);
+        int x1 = (int)floor(centerX + span - 0.5);
+        if (x0 < 0) x0 = 0;
+        if (x1 >= fb->width) x1 = fb->width - 1;
+
+        if (x0 <= x1) {
+            FillSpan(fb->pixels + (size_t)y * fb->stride + x0, x1 - x0 + 1, color);
+        }
+    }
+}
+
+// Fill a polygon given as x, y pairs, sampling pixel centers (even-odd rule)
+void FillPolygon(Framebuffer* fb, const int* points, int count, uint32_t color) {
+    if (count < 3 || count > FB_MAX_POLYGON_POINTS) {
+        return;
+    }
+    if (count == 3) {
+        FillTriangle(fb, points[0], points[1], points[2], points[3], points[4], points[5], color);
+        return;
+    }
+
+    int minY = points[1], maxY = points[1];
+    for (int i = 1; i < count; i++) {
+        if (points[i * 2 + 1] < minY) minY = points[i * 2 + 1];
+        if (points[i * 2 + 1] > maxY) maxY = points[i * 2 + 1];
+    }
+    if (minY < 0) minY = 0;
+    if (maxY > fb->height) maxY = fb->height;
+
+    double crossings[FB_MAX_POLYGON_POINTS];
+    for (int y = minY; y < maxY; y++) {
+        double sampleY = y + 0.5;
+        int crossingCount = 0;
+
+        for (int i = 0; i < count; i++) {
+            int j = (i + 1) % count;
+            double x0 = points[i * 2], y0 = points[i * 2 + 1];
+            double x1 = points[j * 2], y1 = points[j * 2 + 1];
+            if ((y0 <= sampleY && sampleY < y1) || (y1 <= sampleY && sampleY < y0)) {
+                double x = x0 + (sampleY - y0) * (x1 - x0) / (y1 - y0);
+
+                // Insertion sort, there are only a handful of crossings
+                int k = crossingCount++;
+                while (k > 0 && crossings[k - 1] > x) {
+                    crossings[k] = crossings[k - 1];
+                    k--;
+                }
+                crossings[k] = x;
+            }
+        }
+
+        uint32_t* row = fb->pixels + (size_t)y * fb->stride;
+        for (int i = 0; i + 1 < crossingCount; i += 2) {
+            int x0 = (int)ceil(crossings[i] - 0.5);
+            int x1 = (int)ceil(crossings[i + 1] - 0.5);
+            if (x0 < 0) x0 = 0;
+            if (x1 > fb->width) x1 = fb->width;
+            if (x0 < x1) {
+                FillSpan(row + x0, x1 - x0, color);
+            }
+        }
+    }
+}
+
+// Fill a triangle, pixel for pixel what FillPolygon gives for the same
+// three points: same pixel-center sampling and the same crossing formula,
+// without the per-row sort over a general edge list
+void FillTriangle(Framebuffer* fb, int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color) {
+    const int xs[3] = {x0, x1, x2};
+    const int ys[3] = {y0, y1, y2};
+    int minY = y0 < y1 ? y0 : y1;
+    int maxY = y0 > y1 ? y0 : y1;
+    if (y2 < minY) minY = y2;
+    if (y2 > maxY) maxY = y2;
+    if (minY < 0) minY = 0;
+    if (maxY > fb->height) maxY = fb->height;
+
+    for (int y = minY; y < maxY; y++) {
+        double sampleY = y + 0.5;
+        double crossings[3];
+        int crossingCount = 0;
+        for (int i = 0; i < 3; i++) {
+            int j = i == 2 ? 0 : i + 1;
+            double ex0 = xs[i], ey0 = ys[i];
+            double ex1 = xs[j], ey1 = ys[j];
+            if ((ey0 <= sampleY && sampleY < ey1) || (ey1 <= sampleY && sampleY < ey0)) {
+                crossings[crossingCount++] = ex0 + (sampleY - ey0) * (ex1 - ex0) / (ey1 - ey0);
+            }
+        }
+        if (crossingCount < 2) {
+            continue;
+        }
+        double left = crossings[0] < crossings[1] ? crossings[0] : crossings[1];
+        double right = crossings[0] < crossings[1] ? crossings[1] : crossings[0];
+        int start = (int)ceil(left - 0.5);
+        int end = (int)ceil(right - 0.5);
+        if (start < 0) start = 0;
+        if (end > fb->width) end = fb->width;
+        if (start < end) {
+            FillSpan(fb->pixels + (size_t)y * fb->stride + start, end - start, color);
+        }
+    }
+}
+
+// Bresenham line; like GDI LineTo the end point itself is not drawn
+void DrawLine(Framebuffer* fb, int x0, int y0, int x1, int y1, uint32_t color) {
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int stepX = x0 < x1 ? 1 : -1;
+    int stepY = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+
+    while (x0 != x1 || y0 != y1) {
+        if (x0 >= 0 && x0 < fb->width && y0 >= 0 && y0 < fb->height) {
+            fb->pixels[(size_t)y0 * fb->stride + x0] = color;
+        }
+        int error2 = error * 2;
+        if (error2 >= dy) {
+            error += dy;
+            x0 += stepX;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y0 += stepY;
+        }
+    }
+}
+
+// Write the framebuffer as a binary PPM (P6), for eyeballing frames and
+// diffing them against golden images
+bool WriteFramebufferPpm(const Framebuffer* fb, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", fb->width, fb->height);
+    bool ok = true;
+    uint8_t line[3 * 4096];
+    for (int y = 0; y < fb->height && ok; y++) {
+        const uint32_t* row = fb->pixels + (size_t)y * fb->stride;
+        for (int x = 0; x < fb->width && ok; x += 4096) {
+            int count = fb->width - x < 4096 ? fb->width - x : 4096;
+            for (int i = 0; i < count; i++) {
+                line[i * 3] = (uint8_t)FB_RED(row[x + i]);
+                line[i * 3 + 1] = (uint8_t)FB_GREEN(row[x + i]);
+                line[i * 3 + 2] = (uint8_t)FB_BLUE(row[x + i]);
+            }
+            ok = fwrite(line, 3, (size_t)count, file) == (size_t)count;
+        }
+    }
+    return fclose(file) == 0 && ok;
+}
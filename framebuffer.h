@@ -0,0 +1,33 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Pixels are 0x00RRGGBB, the layout of a 32-bit top-down DIB section
+#define FB_RGB(r, g, b) ((uint32_t)(((r) << 16) | ((g) << 8) | (b)))
+#define FB_RED(c) (((c) >> 16) & 0xFF)
+#define FB_GREEN(c) (((c) >> 8) & 0xFF)
+#define FB_BLUE(c) ((c) & 0xFF)
+
+// Largest polygon FillPolygon accepts
+#define FB_MAX_POLYGON_POINTS 16
+
+// In-memory 32-bit framebuffer
+typedef struct {
+    uint32_t* pixels;
+    int width, height;
+    int stride; // pixels per row
+} Framebuffer;
+
+bool CreateFramebuffer(Framebuffer* fb, int width, int height);
+void DestroyFramebuffer(Framebuffer* fb);
+void ClearFramebuffer(Framebuffer* fb, uint32_t color);
+void FillRectangle(Framebuffer* fb, int left, int top, int right, int bottom, uint32_t color);
+void FillEllipse(Framebuffer* fb, int left, int top, int right, int bottom, uint32_t color);
+void FillPolygon(Framebuffer* fb, const int* points, int count, uint32_t color);
+void FillTriangle(Framebuffer* fb, int x0, int y0, int x1, int y1, int x2, int y2, uint32_t color);
+void DrawLine(Framebuffer* fb, int x0, int y0, int x1, int y1, uint32_t color);
+bool WriteFramebufferPpm(const Framebuffer* fb, const char* path);
+
+#endif
@@ -0,0 +1,715 @@
+#include "game.h"
+#include "collision.h"
+#include "particles.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The classic game
+void DefaultGameConfig(GameConfig* config) {
+    config->worldWidth = WINDOW_WIDTH;
+    config->worldHeight = WINDOW_HEIGHT;
+    config->alienRows = ALIEN_ROWS;
+    config->alienCols = ALIEN_COLS;
+    config->shieldCount = SHIELD_COUNT;
+    config->playerBullets = MAX_PLAYER_BULLETS;
+    config->alienBullets = MAX_ALIEN_BULLETS;
+    config->explosions = MAX_EXPLOSIONS;
+    config->playerSpeed = PLAYER_SPEED;
+    config->playerBulletSpeed = PLAYER_BULLET_SPEED;
+    config->alienBulletSpeed = ALIEN_BULLET_SPEED;
+    config->alienMoveSpeed = ALIEN_MOVE_SPEED;
+    config->alienShootDelay = 0;
+    config->alienVolley = 1;
+    config->levels = 10;
+    config->moveDelayStart = 30;
+    config->moveDelayStep = 2;
+    config->moveDelayMin = 10;
+    config->shootDelayStart = 60;
+    config->shootDelayStep = 5;
+    config->shootDelayMin = 20;
+    config->particles = 0;
+}
+
+// Size a game from its configuration: the bullet and explosion pools, the
+// collision grid and the particles are allocated here, everything else
+// lives in the game itself. Call SeedGame and InitializeGame next.
+bool CreateGame(Game* game, const GameConfig* config) {
+    memset(game, 0, sizeof(Game));
+    game->config = *config;
+    if (config->shieldCount > MAX_SHIELDS) game->config.shieldCount = MAX_SHIELDS;
+    if (config->alienRows > FORMATION_MAX_ROWS) game->config.alienRows = FORMATION_MAX_ROWS;
+    if (config->alienCols > FORMATION_MAX_COLS) game->config.alienCols = FORMATION_MAX_COLS;
+    if (config->levels > MAX_LEVELS) game->config.levels = MAX_LEVELS;
+    
+    game->playerBullets = malloc(sizeof(Bullet) * config->playerBullets);
+    game->alienBullets = malloc(sizeof(Bullet) * config->alienBullets);
+    game->explosions = malloc(sizeof(Explosion) * config->explosions);
+    game->collisionGrid = malloc(sizeof(CollisionGrid));
+    if (game->playerBullets == NULL || game->alienBullets == NULL || game->explosions == NULL ||
+        game->collisionGrid == NULL ||
+        !CreateCollisionGrid(game->collisionGrid, config->worldWidth, config->worldHeight)) {
+        DestroyGame(game);
+        return false;
+    }
+    InitPool(&game->playerBulletPool, config->playerBullets);
+    InitPool(&game->alienBulletPool, config->alienBullets);
+    InitPool(&game->explosionPool, config->explosions);
+    
+    if (config->particles > 0) {
+        game->particles = malloc(sizeof(ParticleSystem));
+        if (game->particles == NULL || !CreateParticleSystem(game->particles, config->particles)) {
+            free(game->particles);
+            game->particles = NULL;
+            DestroyGame(game);
+            return false;
+        }
+    }
+    return true;
+}
+
+void DestroyGame(Game* game) {
+    if (game->collisionGrid != NULL) {
+        DestroyCollisionGrid(game->collisionGrid);
+    }
+    free(game->collisionGrid);
+    if (game->particles != NULL) {
+        DestroyParticleSystem(game->particles);
+    }
+    free(game->particles);
+    free(game->playerBullets);
+    free(game->alienBullets);
+    free(game->explosions);
+    game->collisionGrid = NULL;
+    game->playerBullets = NULL;
+    game->alienBullets = NULL;
+    game->explosions = NULL;
+    game->particles = NULL;
+}
+
+// Copy the whole state of a game into another one created with the same
+// pool capacities. The destination keeps its own storage, particles and
+// phase marker.
+bool CopyGame(Game* destination, const Game* source) {
+    if (destination->playerBulletPool.capacity != source->playerBulletPool.capacity ||
+        destination->alienBulletPool.capacity != source->alienBulletPool.capacity ||
+        destination->explosionPool.capacity != source->explosionPool.capacity) {
+        return false;
+    }
+    memcpy(destination, source, offsetof(Game, playerBullets));
+    memcpy(destination->playerBullets, source->playerBullets, sizeof(Bullet) * source->playerBulletPool.count);
+    memcpy(destination->alienBullets, source->alienBullets, sizeof(Bullet) * source->alienBulletPool.count);
+    memcpy(destination->explosions, source->explosions, sizeof(Explosion) * source->explosionPool.count);
+    return true;
+}
+
+// Bytewise comparison of the state of two games, pool entries included
+bool SameGame(const Game* a, const Game* b) {
+    return memcmp(a, b, offsetof(Game, playerBullets)) == 0 &&
+           memcmp(a->playerBullets, b->playerBullets, sizeof(Bullet) * a->playerBulletPool.count) == 0 &&
+           memcmp(a->alienBullets, b->alienBullets, sizeof(Bullet) * a->alienBulletPool.count) == 0 &&
+           memcmp(a->explosions, b->explosions, sizeof(Explosion) * a->explosionPool.count) == 0;
+}
+
+const char* GamePhaseName(GamePhase phase) {
+    static const char* names[] = {"input", "aliens", "bullets", "explosions", "collisions", "cleanup", "particles"};
+    return phase < GAME_PHASE_COUNT ? names[phase] : "total";
+}
+
+static void MarkPhase(Game* game, GamePhase phase) {
+    if (game->phaseMarker != NULL) {
+        game->phaseMarker(game->phaseContext, phase);
+    }
+}
+
+// Start a session: seed the gameplay random stream and reset the tick
+// counter. The same seed and the same inputs on the same ticks give the
+// same game.
+void SeedGame(Game* game, uint64_t seed) {
+    game->seed = seed;
+    SeedRandom(&game->rng, seed, 0);
+    game->tick = 0;
+    game->stepTicks = 1;
+    game->pendingInputCount = 0;
+}
+
+// Initialize the game
+void InitializeGame(Game* game) {
+    // Initialize game state
+    game->state = GAME_MENU;
+    game->score = 0;
+    game->level = 1;
+    game->playerLives = 3;
+    
+    // Initialize player
+    game->playerX = (game->config.worldWidth - PLAYER_WIDTH) / 2;
+    game->playerY = game->config.worldHeight - PLAYER_HEIGHT - 20;
+    game->prevPlayerX = game->playerX;
+    
+    // Initialize bullet and explosion pools, all empty
+    InitPool(&game->playerBulletPool, game->config.playerBullets);
+    InitPool(&game->alienBulletPool, game->config.alienBullets);
+    InitPool(&game->explosionPool, game->config.explosions);
+    if (game->particles != NULL) {
+        ClearParticles(game->particles);
+    }
+    
+    // Initialize aliens
+    InitializeLevel(game);
+    
+    // Initialize shields
+    InitializeShields(game);
+}
+
+// Initialize level
+void InitializeLevel(Game* game) {
+    const GameConfig* config = &game->config;
+    
+    // Initialize aliens
+    InitFormation(&game->formation, config->alienRows, config->alienCols, 100, 80,
+                  ALIEN_WIDTH + ALIEN_SPACING_H, ALIEN_HEIGHT + ALIEN_SPACING_V,
+                  ALIEN_WIDTH, ALIEN_HEIGHT);
+    
+    // Initialize alien movement
+    game->alienDirection = DIR_RIGHT;
+    game->alienMoveTimer = 0;
+    game->alienMoveDelay = config->moveDelayStart - (game->level * config->moveDelayStep);
+    if (game->alienMoveDelay < config->moveDelayMin) game->alienMoveDelay = config->moveDelayMin;
+    game->alienDropDistance = 20;
+    
+    // Initialize alien shooting
+    game->alienShootTimer = 0;
+    game->alienShootDelay = config->shootDelayStart - (game->level * config->shootDelayStep);
+    if (game->alienShootDelay < config->shootDelayMin) game->alienShootDelay = config->shootDelayMin;
+    if (config->alienShootDelay > 0) game->alienShootDelay = config->alienShootDelay;
+    
+    // Initialize shields
+    InitializeShields(game);
+}
+
+// Initialize shields
+void InitializeShields(Game* game) {
+    int shieldCount = game->config.shieldCount;
+    int shieldSpacing = (game->config.worldWidth - (shieldCount * SHIELD_WIDTH)) / (shieldCount + 1);
+    
+    for (int s = 0; s < shieldCount; s++) {
+        game->shields[s].x = shieldSpacing + s * (SHIELD_WIDTH + shieldSpacing);
+        game->shields[s].y = game->config.worldHeight - 150;
+        
+        // Initialize shield blocks
+        for (int y = 0; y < SHIELD_ROWS; y++) {
+            game->shields[s].rows[y] = 0;
+        }
+        for (int x = 0; x < SHIELD_COLS; x++) {
+            for (int y = 0; y < SHIELD_ROWS; y++) {
+                // Create shield shape (arch)
+                bool isActive = true;
+                
+                // Create an arch shape
+                if (y > SHIELD_ROWS * 0.6 && 
+                    x > SHIELD_COLS * 0.3 && 
+                    x < SHIELD_COLS * 0.7) {
+                    isActive = false;
+                }
+                
+                if (isActive) {
+                    game->shields[s].rows[y] |= (uint16_t)(1u << x);
+                }
+            }
+        }
+    }
+}
+
+// Give inactive bullets back to their pool
+static void ReleaseSpentBullets(Pool* pool, Bullet* bullets) {
+    for (int i = 0; i < pool->count;) {
+        if (bullets[i].active) {
+            i++;
+        } else {
+            ReleaseSlot(pool, bullets, sizeof(Bullet), i);
+        }
+    }
+}
+
+static void ReleaseFinishedExplosions(Game* game) {
+    for (int i = 0; i < game->explosionPool.count;) {
+        if (game->explosions[i].active) {
+            i++;
+        } else {
+            ReleaseSlot(&game->explosionPool, game->explosions, sizeof(Explosion), i);
+        }
+    }
+}
+
+// Positions at the start of a tick, for render interpolation and for the
+// path each bullet sweeps during the tick
+static void RememberPositions(Game* game) {
+    game->prevPlayerX = game->playerX;
+    for (int i = 0; i < game->playerBulletPool.count; i++) {
+        game->playerBullets[i].prevX = game->playerBullets[i].x;
+        game->playerBullets[i].prevY = game->playerBullets[i].y;
+    }
+    for (int i = 0; i < game->alienBulletPool.count; i++) {
+        game->alienBullets[i].prevX = game->alienBullets[i].x;
+        game->alienBullets[i].prevY = game->alienBullets[i].y;
+    }
+}
+
+// One tick of the simulation after the inputs
+static void PlayTick(Game* game) {
+    if (game->state == GAME_PLAYING) {
+        // Move aliens
+        MarkPhase(game, GAME_PHASE_ALIENS);
+        game->alienMoveTimer++;
+        while (game->alienMoveTimer >= game->alienMoveDelay && game->state == GAME_PLAYING) {
+            game->alienMoveTimer -= game->alienMoveDelay;
+            MoveAliens(game);
+        }
+        
+        // Alien shooting
+        game->alienShootTimer++;
+        while (game->alienShootTimer >= game->alienShootDelay) {
+            game->alienShootTimer -= game->alienShootDelay;
+            for (int v = 0; v < game->config.alienVolley; v++) {
+                FireAlienBullet(game);
+            }
+        }
+        
+        // Move player bullets
+        MarkPhase(game, GAME_PHASE_BULLETS);
+        for (int i = 0; i < game->playerBulletPool.count; i++) {
+            game->playerBullets[i].y -= game->config.playerBulletSpeed;
+        }
+        
+        // Move alien bullets
+        for (int i = 0; i < game->alienBulletPool.count; i++) {
+            game->alienBullets[i].y += game->config.alienBulletSpeed;
+        }
+        
+        // Bullet trails
+        if (game->particles != NULL) {
+            for (int i = 0; i < game->playerBulletPool.count; i++) {
+                const Bullet* bullet = &game->playerBullets[i];
+                SpawnTrail(game->particles, bullet->x, bullet->y, PARTICLE_RGB(255, 255, 255));
+            }
+            for (int i = 0; i < game->alienBulletPool.count; i++) {
+                const Bullet* bullet = &game->alienBullets[i];
+                SpawnTrail(game->particles, bullet->x, bullet->y, PARTICLE_RGB(255, 100, 100));
+            }
+        }
+        
+        // Update explosions
+        MarkPhase(game, GAME_PHASE_EXPLOSIONS);
+        UpdateExplosions(game, 1);
+        
+        // Check collisions along the path of every bullet, then drop the
+        // bullets that hit something or left the world
+        MarkPhase(game, GAME_PHASE_COLLISIONS);
+        CheckCollisions(game);
+        MarkPhase(game, GAME_PHASE_CLEANUP);
+        for (int i = 0; i < game->playerBulletPool.count; i++) {
+            if (game->playerBullets[i].y < 0) {
+                game->playerBullets[i].active = false;
+            }
+        }
+        for (int i = 0; i < game->alienBulletPool.count; i++) {
+            if (game->alienBullets[i].y > game->config.worldHeight) {
+                game->alienBullets[i].active = false;
+            }
+        }
+        ReleaseSpentBullets(&game->playerBulletPool, game->playerBullets);
+        ReleaseSpentBullets(&game->alienBulletPool, game->alienBullets);
+        
+        // Check win condition
+        if (game->formation.liveCount == 0) {
+            game->level++;
+            if (game->level > game->config.levels) {
+                game->state = GAME_WIN;
+            } else {
+                InitializeLevel(game);
+            }
+        }
+    } else if (game->state == GAME_OVER) {
+        game->gameOverTimer++;
+        if (game->gameOverTimer > 180) { // 3 seconds at 60 FPS
+            game->state = GAME_MENU;
+        }
+    }
+    
+    // Particles are cosmetic and keep fading whatever the state
+    MarkPhase(game, GAME_PHASE_PARTICLES);
+    if (game->particles != NULL) {
+        UpdateParticles(game->particles);
+    }
+}
+
+// How many of the coming ticks, at most limit, are quiet: the formation
+// neither moves nor fires, no explosion ends and no bullet can hit anything
+// or leave the world, so bullets only fly and explosions only age. Errs on
+// the short side; a tick it leaves out is simply played.
+static int QuietTicks(Game* game, int limit) {
+    int quiet = limit;
+    if (game->alienMoveDelay - game->alienMoveTimer - 1 < quiet) {
+        quiet = game->alienMoveDelay - game->alienMoveTimer - 1;
+    }
+    if (game->alienShootDelay - game->alienShootTimer - 1 < quiet) {
+        quiet = game->alienShootDelay - game->alienShootTimer - 1;
+    }
+    for (int i = 0; i < game->explosionPool.count && quiet > 0; i++) {
+        const Explosion* explosion = &game->explosions[i];
+        int left = (EXPLOSION_FRAMES - explosion->frame) * EXPLOSION_DURATION - explosion->timer;
+        if (left - 1 < quiet) {
+            quiet = left - 1;
+        }
+    }
+    
+    // Bullets leave the world on the tick that takes them past its edge
+    int playerSpeed = game->config.playerBulletSpeed;
+    int alienSpeed = game->config.alienBulletSpeed;
+    if ((game->playerBulletPool.count > 0 && playerSpeed <= 0) ||
+        (game->alienBulletPool.count > 0 && alienSpeed <= 0)) {
+        return 0;
+    }
+    for (int i = 0; i < game->playerBulletPool.count && quiet > 0; i++) {
+        int inside = game->playerBullets[i].y / playerSpeed;
+        if (inside < quiet) {
+            quiet = inside;
+        }
+    }
+    for (int i = 0; i < game->alienBulletPool.count && quiet > 0; i++) {
+        int inside = (game->config.worldHeight - game->alienBullets[i].y) / alienSpeed;
+        if (inside < quiet) {
+            quiet = inside;
+        }
+    }
+    if (quiet <= 0) {
+        return 0;
+    }
+    
+    // The player may have moved and the formation shrunk since the last pass
+    BuildCollisionGrid(game->collisionGrid, game);
+    return QuietBulletTicks(game, game->collisionGrid, quiet);
+}
+
+// Play ticks ticks that QuietTicks found quiet, all at once. Previous
+// positions end up at the start of the last of them, as if it was played.
+static void SkipQuietTicks(Game* game, int ticks) {
+    MarkPhase(game, GAME_PHASE_BULLETS);
+    int playerTravel = game->config.playerBulletSpeed * ticks;
+    for (int i = 0; i < game->playerBulletPool.count; i++) {
+        Bullet* bullet = &game->playerBullets[i];
+        bullet->y -= playerTravel;
+        bullet->prevX = bullet->x;
+        bullet->prevY = bullet->y + game->config.playerBulletSpeed;
+    }
+    int alienTravel = game->config.alienBulletSpeed * ticks;
+    for (int i = 0; i < game->alienBulletPool.count; i++) {
+        Bullet* bullet = &game->alienBullets[i];
+        bullet->y += alienTravel;
+        bullet->prevX = bullet->x;
+        bullet->prevY = bullet->y - game->config.alienBulletSpeed;
+    }
+    
+    // Trails only where the bullets end up, they are cosmetic
+    if (game->particles != NULL) {
+        for (int i = 0; i < game->playerBulletPool.count; i++) {
+            const Bullet* bullet = &game->playerBullets[i];
+            SpawnTrail(game->particles, bullet->x, bullet->y, PARTICLE_RGB(255, 255, 255));
+        }
+        for (int i = 0; i < game->alienBulletPool.count; i++) {
+            const Bullet* bullet = &game->alienBullets[i];
+            SpawnTrail(game->particles, bullet->x, bullet->y, PARTICLE_RGB(255, 100, 100));
+        }
+    }
+    
+    MarkPhase(game, GAME_PHASE_EXPLOSIONS);
+    UpdateExplosions(game, ticks);
+    game->alienMoveTimer += ticks;
+    game->alienShootTimer += ticks;
+    
+    MarkPhase(game, GAME_PHASE_PARTICLES);
+    if (game->particles != NULL) {
+        for (int t = 0; t < ticks; t++) {
+            UpdateParticles(game->particles);
+        }
+    }
+}
+
+// Update game state. An update covers stepTicks ticks, more than one when
+// fast-forwarding, and ends exactly where as many single-tick updates with
+// the same inputs would: every tick where something can happen is played
+// on its own, and only runs of ticks where bullets just fly are skipped in
+// one go.
+void UpdateGame(Game* game) {
+    // Remember where everything was for render interpolation
+    RememberPositions(game);
+    
+    // Apply the inputs queued for this tick
+    MarkPhase(game, GAME_PHASE_INPUT);
+    for (int i = 0; i < game->pendingInputCount; i++) {
+        HandleInput(game, game->pendingInputs[i]);
+    }
+    game->pendingInputCount = 0;
+    
+    int steps = game->stepTicks;
+    for (int done = 0; done < steps;) {
+        int quiet = game->state == GAME_PLAYING && steps > 1 ? QuietTicks(game, steps - done) : 0;
+        if (quiet > 0) {
+            SkipQuietTicks(game, quiet);
+            done += quiet;
+            if (done > 1) {
+                game->prevPlayerX = game->playerX;
+            }
+        } else {
+            if (done > 0) {
+                RememberPositions(game);
+            }
+            PlayTick(game);
+            done++;
+        }
+    }
+    
+    game->tick += steps;
+    MarkPhase(game, GAME_PHASE_COUNT);
+}
+
+// Queue an input for the next tick
+bool QueueInput(Game* game, GameInput input) {
+    if (game->pendingInputCount >= MAX_PENDING_INPUTS) {
+        return false;
+    }
+    game->pendingInputs[game->pendingInputCount++] = input;
+    return true;
+}
+
+// Apply one input to the game
+void HandleInput(Game* game, GameInput input) {
+    switch (input) {
+        case INPUT_LEFT:
+            if (game->state == GAME_PLAYING) {
+                MovePlayer(game, -1);
+            }
+            break;
+            
+        case INPUT_RIGHT:
+            if (game->state == GAME_PLAYING) {
+                MovePlayer(game, 1);
+            }
+            break;
+            
+        case INPUT_FIRE:
+            if (game->state == GAME_PLAYING) {
+                FirePlayerBullet(game);
+            } else if (game->state == GAME_MENU) {
+                game->state = GAME_PLAYING;
+                InitializeLevel(game);
+            } else if (game->state == GAME_OVER || game->state == GAME_WIN) {
+                InitializeGame(game);
+            }
+            break;
+            
+        case INPUT_ESCAPE:
+            if (game->state == GAME_PLAYING) {
+                game->state = GAME_MENU;
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+// FNV-1a over the gameplay state, to compare runs without comparing memory
+static uint64_t HashInt(uint64_t hash, int64_t value) {
+    for (int i = 0; i < 8; i++) {
+        hash ^= (uint64_t)(value >> (i * 8)) & 0xFF;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t HashBullet(uint64_t hash, const Bullet* bullet) {
+    hash = HashInt(hash, bullet->x);
+    hash = HashInt(hash, bullet->y);
+    return hash;
+}
+
+uint64_t HashGame(const Game* game) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = HashInt(hash, game->state);
+    hash = HashInt(hash, game->tick);
+    hash = HashInt(hash, game->score);
+    hash = HashInt(hash, game->level);
+    hash = HashInt(hash, game->playerLives);
+    hash = HashInt(hash, game->playerX);
+    hash = HashInt(hash, (int64_t)game->rng.state);
+    
+    hash = HashInt(hash, game->playerBulletPool.count);
+    for (int i = 0; i < game->playerBulletPool.count; i++) {
+        hash = HashBullet(hash, &game->playerBullets[i]);
+    }
+    hash = HashInt(hash, game->alienBulletPool.count);
+    for (int i = 0; i < game->alienBulletPool.count; i++) {
+        hash = HashBullet(hash, &game->alienBullets[i]);
+    }
+    
+    const Formation* formation = &game->formation;
+    hash = HashInt(hash, formation->liveCount);
+    hash = HashInt(hash, game->alienDirection);
+    hash = HashInt(hash, game->alienMoveTimer);
+    hash = HashInt(hash, game->alienShootTimer);
+    for (int row = 0; row < formation->rows; row++) {
+        for (int col = 0; col < formation->cols; col++) {
+            bool alive = IsAlienAlive(formation, row, col);
+            hash = HashInt(hash, alive);
+            if (alive) {
+                hash = HashInt(hash, AlienX(formation, col));
+                hash = HashInt(hash, AlienY(formation, row));
+            }
+        }
+    }
+    
+    for (int s = 0; s < game->config.shieldCount; s++) {
+        for (int x = 0; x < SHIELD_COLS; x++) {
+            for (int y = 0; y < SHIELD_ROWS; y++) {
+                hash = HashInt(hash, IsShieldBlockActive(&game->shields[s], x, y));
+            }
+        }
+    }
+    
+    hash = HashInt(hash, game->explosionPool.count);
+    for (int i = 0; i < game->explosionPool.count; i++) {
+        const Explosion* explosion = &game->explosions[i];
+        hash = HashInt(hash, explosion->x);
+        hash = HashInt(hash, explosion->y);
+        hash = HashInt(hash, explosion->frame * EXPLOSION_DURATION + explosion->timer);
+    }
+    return hash;
+}
+
+// Move player
+void MovePlayer(Game* game, int direction) {
+    game->playerX += direction * game->config.playerSpeed;
+    
+    // Keep player within bounds
+    if (game->playerX < 0) {
+        game->playerX = 0;
+    } else if (game->playerX > game->config.worldWidth - PLAYER_WIDTH) {
+        game->playerX = game->config.worldWidth - PLAYER_WIDTH;
+    }
+}
+
+// Fire player bullet
+void FirePlayerBullet(Game* game) {
+    // Take a free bullet, if any
+    int i = AcquireSlot(&game->playerBulletPool);
+    if (i < 0) {
+        return;
+    }
+    game->playerBullets[i].active = true;
+    game->playerBullets[i].x = game->playerX + PLAYER_WIDTH / 2;
+    game->playerBullets[i].y = game->playerY;
+    game->playerBullets[i].prevX = game->playerBullets[i].x;
+    game->playerBullets[i].prevY = game->playerBullets[i].y;
+}
+
+// Fire alien bullet from the lowest alien of a random live column
+void FireAlienBullet(Game* game) {
+    const Formation* formation = &game->formation;
+    if (formation->liveCount == 0) {
+        return;
+    }
+    
+    // Take a free bullet, if any
+    int i = AcquireSlot(&game->alienBulletPool);
+    if (i < 0) {
+        return;
+    }
+    int col = formation->liveColumns[RandomRange(&game->rng, formation->liveColumnCount)];
+    int row = formation->lowestRow[col];
+    
+    game->alienBullets[i].active = true;
+    game->alienBullets[i].x = AlienX(formation, col) + formation->width / 2;
+    game->alienBullets[i].y = AlienY(formation, row) + formation->height;
+    game->alienBullets[i].prevX = game->alienBullets[i].x;
+    game->alienBullets[i].prevY = game->alienBullets[i].y;
+}
+
+// Move aliens: the whole formation steps sideways, or drops and turns
+// around when its outermost live column would leave the world
+void MoveAliens(Game* game) {
+    Formation* formation = &game->formation;
+    if (formation->liveCount == 0) {
+        return;
+    }
+    
+    // Check if aliens should change direction
+    int speed = game->config.alienMoveSpeed;
+    bool shouldDropAndReverse;
+    if (game->alienDirection == DIR_RIGHT) {
+        shouldDropAndReverse = AlienX(formation, formation->maxCol) + formation->width + speed > game->config.worldWidth;
+    } else {
+        shouldDropAndReverse = AlienX(formation, formation->minCol) - speed < 0;
+    }
+    
+    // Move aliens
+    if (shouldDropAndReverse) {
+        // Drop aliens
+        formation->originY += game->alienDropDistance;
+        
+        // Check if aliens reached the bottom (player loses)
+        if (AlienY(formation, formation->lowestLiveRow) + formation->height > game->playerY) {
+            game->playerLives = 0;
+            game->state = GAME_OVER;
+            game->gameOverTimer = 0;
+            return;
+        }
+        
+        // Reverse direction
+        game->alienDirection = (game->alienDirection == DIR_RIGHT) ? DIR_LEFT : DIR_RIGHT;
+    } else {
+        // Move aliens horizontally
+        formation->originX += (game->alienDirection == DIR_RIGHT) ? speed : -speed;
+    }
+}
+
+// Check collisions. Every pass goes through the broadphase grid and sweeps
+// each bullet along the path it travelled since the last update.
+void CheckCollisions(Game* game) {
+    BuildCollisionGrid(game->collisionGrid, game);
+    
+    CollidePlayerBullets(game, game->collisionGrid, game->playerBullets, game->playerBulletPool.count);
+    CollideAlienBullets(game, game->collisionGrid, game->alienBullets, game->alienBulletPool.count);
+}
+
+// Advance every explosion by a number of ticks and release the ones whose
+// last frame has played
+void UpdateExplosions(Game* game, int steps) {
+    for (int i = 0; i < game->explosionPool.count; i++) {
+        Explosion* explosion = &game->explosions[i];
+        explosion->timer += steps;
+        while (explosion->active && explosion->timer >= EXPLOSION_DURATION) {
+            explosion->timer -= EXPLOSION_DURATION;
+            explosion->frame++;
+            if (explosion->frame >= EXPLOSION_FRAMES) {
+                explosion->active = false;
+            }
+        }
+    }
+    ReleaseFinishedExplosions(game);
+}
+
+// Create explosion
+void CreateExplosion(Game* game, int x, int y) {
+    int i = AcquireSlot(&game->explosionPool);
+    if (i < 0) {
+        return;
+    }
+    game->explosions[i].x = x;
+    game->explosions[i].y = y;
+    game->explosions[i].frame = 0;
+    game->explosions[i].timer = 0;
+    game->explosions[i].active = true;
+    SpawnSparks(game->particles, x, y);
+}
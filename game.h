@@ -0,0 +1,229 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "formation.h"
+#include "pool.h"
+#include "rng.h"
+
+// Window dimensions
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 600
+
+// Game constants. The world size, formation, pool capacities, shield count
+// and speeds below are the classic defaults of GameConfig.
+#define PLAYER_WIDTH 60
+#define PLAYER_HEIGHT 40
+#define PLAYER_SPEED 8
+#define PLAYER_BULLET_SPEED 12
+#define ALIEN_ROWS 5
+#define ALIEN_COLS 11
+#define ALIEN_WIDTH 40
+#define ALIEN_HEIGHT 40
+#define ALIEN_SPACING_H 20
+#define ALIEN_SPACING_V 15
+#define ALIEN_BULLET_SPEED 6
+#define ALIEN_MOVE_SPEED 2
+#define MAX_PLAYER_BULLETS 3
+#define MAX_ALIEN_BULLETS 8
+#define MAX_EXPLOSIONS 20
+#define SHIELD_COUNT 4
+#define SHIELD_WIDTH 80
+#define SHIELD_HEIGHT 60
+#define SHIELD_BLOCK_SIZE 8
+#define SHIELD_COLS (SHIELD_WIDTH/SHIELD_BLOCK_SIZE)
+#define SHIELD_ROWS (SHIELD_HEIGHT/SHIELD_BLOCK_SIZE)
+#define EXPLOSION_FRAMES 8
+#define EXPLOSION_DURATION 4
+#define MAX_PENDING_INPUTS 16
+#define MAX_SHIELDS 30 // one collision grid bit each
+#define MAX_LEVELS 32
+
+// Runtime configuration, fixed for the life of a game. DefaultGameConfig
+// gives the classic game; scenarios change any of it for stress runs or
+// difficulty tuning.
+typedef struct {
+    int worldWidth, worldHeight;
+    int alienRows, alienCols;  // at most FORMATION_MAX_ROWS x FORMATION_MAX_COLS
+    int shieldCount;           // at most MAX_SHIELDS
+    int playerBullets;         // pool capacities
+    int alienBullets;
+    int explosions;
+    int playerSpeed;
+    int playerBulletSpeed;
+    int alienBulletSpeed;
+    int alienMoveSpeed;
+    int alienShootDelay;       // ticks between volleys, 0 for the per-level delay
+    int alienVolley;           // bullets fired per volley
+    int levels;                // levels to clear to win, at most MAX_LEVELS
+
+    // Difficulty curve: on level n the formation moves every
+    // moveDelayStart - n * moveDelayStep ticks, never faster than
+    // moveDelayMin, and fires every shootDelayStart - n * shootDelayStep
+    // ticks, never faster than shootDelayMin
+    int moveDelayStart, moveDelayStep, moveDelayMin;
+    int shootDelayStart, shootDelayStep, shootDelayMin;
+    int particles;             // cosmetic particle capacity, 0 for none
+} GameConfig;
+
+// Parts of a tick, in the order UpdateGame runs them
+typedef enum {
+    GAME_PHASE_INPUT,
+    GAME_PHASE_ALIENS,
+    GAME_PHASE_BULLETS,
+    GAME_PHASE_EXPLOSIONS,
+    GAME_PHASE_COLLISIONS,
+    GAME_PHASE_CLEANUP,
+    GAME_PHASE_PARTICLES,
+    GAME_PHASE_COUNT
+} GamePhase;
+
+// Called as each phase starts, and with GAME_PHASE_COUNT when the tick ends
+typedef void (*GamePhaseMarker)(void* context, GamePhase phase);
+
+// Collision scratch space, see collision.h
+typedef struct CollisionGrid CollisionGrid;
+
+// Sparks, debris and trails, see particles.h
+typedef struct ParticleSystem ParticleSystem;
+
+// Game states
+typedef enum {
+    GAME_MENU,
+    GAME_PLAYING,
+    GAME_OVER,
+    GAME_WIN
+} GameState;
+
+// Direction
+typedef enum {
+    DIR_LEFT,
+    DIR_RIGHT
+} Direction;
+
+// Player inputs, applied by the simulation at the start of a tick
+typedef enum {
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_FIRE,
+    INPUT_ESCAPE,
+    INPUT_COUNT
+} GameInput;
+
+// Entity types
+typedef enum {
+    ENTITY_PLAYER,
+    ENTITY_ALIEN,
+    ENTITY_PLAYER_BULLET,
+    ENTITY_ALIEN_BULLET,
+    ENTITY_SHIELD,
+    ENTITY_EXPLOSION
+} EntityType;
+
+// Bullet structure. A bullet that hits something or leaves the window is
+// marked inactive and goes back to its pool at the end of the tick.
+typedef struct {
+    int x, y;
+    int prevX, prevY; // position at the start of the last tick, for rendering
+    bool active;
+} Bullet;
+
+// Shield structure: one bit per block, bit x of rows[y] is the block at
+// column x, row y, found at (x + column * SHIELD_BLOCK_SIZE, y + row * SHIELD_BLOCK_SIZE)
+typedef struct {
+    int x, y;
+    uint16_t rows[SHIELD_ROWS];
+} Shield;
+
+static inline bool IsShieldBlockActive(const Shield* shield, int col, int row) {
+    return (shield->rows[row] >> col) & 1;
+}
+
+// Explosion structure, back to its pool once its last frame has played
+typedef struct {
+    int x, y;
+    int frame;
+    int timer;
+    bool active;
+} Explosion;
+
+// Game structure. CreateGame allocates the pools and the collision grid
+// from the configuration; DestroyGame releases them.
+typedef struct {
+    GameConfig config;
+
+    // Player
+    int playerX, playerY;
+    int prevPlayerX;
+    int playerLives;
+    Pool playerBulletPool;
+
+    // Aliens
+    Formation formation;
+    Direction alienDirection;
+    int alienMoveTimer;
+    int alienMoveDelay;
+    int alienDropDistance;
+    Pool alienBulletPool;
+    int alienShootTimer;
+    int alienShootDelay;
+
+    // Shields
+    Shield shields[MAX_SHIELDS];
+
+    // Explosions
+    Pool explosionPool;
+
+    // Game state
+    GameState state;
+    int score;
+    int level;
+    int gameOverTimer;
+    uint32_t tick;
+    int stepTicks; // ticks simulated per UpdateGame, 1 unless fast-forwarding
+
+    // Inputs waiting for the next tick
+    GameInput pendingInputs[MAX_PENDING_INPUTS];
+    int pendingInputCount;
+
+    // Gameplay random stream, the only source of randomness in the simulation
+    uint64_t seed;
+    Rng rng;
+
+    // Everything from here on is storage, scratch or instrumentation: pool
+    // entries live behind these pointers, the rest is not game state
+    Bullet* playerBullets;
+    Bullet* alienBullets;
+    Explosion* explosions;
+    CollisionGrid* collisionGrid;
+    ParticleSystem* particles;   // NULL when the configuration has none
+    GamePhaseMarker phaseMarker; // NULL unless someone times the phases
+    void* phaseContext;
+} Game;
+
+// Simulation (platform independent, every function works on an explicit game)
+void DefaultGameConfig(GameConfig* config);
+bool CreateGame(Game* game, const GameConfig* config);
+void DestroyGame(Game* game);
+bool CopyGame(Game* destination, const Game* source);
+bool SameGame(const Game* a, const Game* b);
+const char* GamePhaseName(GamePhase phase);
+void SeedGame(Game* game, uint64_t seed);
+void InitializeGame(Game* game);
+void InitializeLevel(Game* game);
+void InitializeShields(Game* game);
+void UpdateGame(Game* game);
+bool QueueInput(Game* game, GameInput input);
+void HandleInput(Game* game, GameInput input);
+uint64_t HashGame(const Game* game);
+void MovePlayer(Game* game, int direction);
+void FirePlayerBullet(Game* game);
+void FireAlienBullet(Game* game);
+void MoveAliens(Game* game);
+void CheckCollisions(Game* game);
+void CreateExplosion(Game* game, int x, int y);
+void UpdateExplosions(Game* game, int steps);
+
+#endif
@@ -0,0 +1,741 @@
+// Headless runner: plays the scripted player, replays a recorded session or
+// benchmarks scenarios without a window, as fast as the CPU allows
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "game.h"
+#include "input.h"
+#include "loop.h"
+#include "rng.h"
+#include "particles.h"
+#include "scenario.h"
+
+#define DEFAULT_TICKS 36000 // ten minutes of play at 60 Hz
+#define TOURNAMENT_TICKS 360000 // a game still going after 100 minutes is a draw
+#define MAX_SCENARIOS 32
+
+static const char* stateNames[] = {"menu", "playing", "game over", "win"};
+
+// Monotonic clock in nanoseconds
+static double NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void PrintUsage(const char* program) {
+    printf("usage: %s [--seed n] [--ticks n] [--record file]   play the scripted player\n", program);
+    printf("       %s [--seed n] [--ticks n] --step n          same, n ticks per update, not recorded\n", program);
+    printf("       %s --replay file                           replay a recorded session\n", program);
+    printf("       %s --scenario file... [--ticks n] [--step n] benchmark scenarios in turn\n", program);
+    printf("       %s --batch n [--seed n] [--ticks n] [--replay file] [--threads n] [--scaling]\n", program);
+    printf("           play n independent games on every core, seeds n, n+1, ... or all replaying one log\n");
+    printf("       %s --tournament n [--scenario file] [--seed n] [--ticks n] [--threads n]\n", program);
+    printf("           n autopilot games, with survival, score and clear time statistics per level\n");
+    printf("       %s --input-latency [--seed n] [--ticks n]\n", program);
+    printf("           synthetic key presses through the per-tick input sampling, with their latency\n");
+}
+
+static void PrintResult(const Game* game, double elapsedNs) {
+    printf("tick %u: %s, level %d, score %d, lives %d\n",
+           game->tick, stateNames[game->state], game->level, game->score, game->playerLives);
+    printf("state hash %016llx\n", (unsigned long long)HashGame(game));
+    printf("%.0f ticks/s (%.1f ns/tick)\n", game->tick / (elapsedNs / 1e9), elapsedNs / game->tick);
+}
+
+// Time spent in each phase of UpdateGame, fed by the game's phase marker
+typedef struct {
+    double ns[GAME_PHASE_COUNT];
+    double last;
+    GamePhase current;
+} PhaseTimes;
+
+static void MarkPhaseTime(void* context, GamePhase phase) {
+    PhaseTimes* times = context;
+    double now = NowNs();
+    if (times->current < GAME_PHASE_COUNT) {
+        times->ns[times->current] += now - times->last;
+    }
+    times->current = phase;
+    times->last = now;
+}
+
+static void PrintPool(const char* name, const Pool* pool) {
+    printf("  %-16s %8d live, capacity %8d, high water %8d, %10u acquires refused\n",
+           name, pool->count, pool->capacity, pool->highWater, pool->exhausted);
+}
+
+// Play a scenario with the scripted player and report where the time goes
+static bool RunScenario(const Scenario* scenario, long ticks, int step) {
+    static Game game;
+    const GameConfig* config = &scenario->config;
+    if (!CreateGame(&game, config)) {
+        fprintf(stderr, "not enough memory for scenario %s\n", scenario->name);
+        return false;
+    }
+    SeedGame(&game, scenario->seed);
+    InitializeGame(&game);
+    game.stepTicks = step;
+
+    PhaseTimes times;
+    memset(&times, 0, sizeof(times));
+    times.current = GAME_PHASE_COUNT;
+    game.phaseMarker = MarkPhaseTime;
+    game.phaseContext = &times;
+
+    double start = NowNs();
+    while (game.tick < (uint32_t)ticks) {
+        GameInput inputs[MAX_PENDING_INPUTS];
+        int count = ScriptedInputs(&game, inputs);
+        for (int i = 0; i < count; i++) {
+            QueueInput(&game, inputs[i]);
+        }
+        UpdateGame(&game);
+    }
+    double elapsed = NowNs() - start;
+
+    printf("scenario %s: %dx%d world, %dx%d aliens, %d shields, seed %llu\n", scenario->name,
+           config->worldWidth, config->worldHeight, config->alienRows, config->alienCols,
+           config->shieldCount, (unsigned long long)scenario->seed);
+    PrintResult(&game, elapsed);
+    double timed = 0;
+    for (int phase = 0; phase < GAME_PHASE_COUNT; phase++) {
+        timed += times.ns[phase];
+    }
+    printf("  %-16s %12s %8s\n", "phase", "ns/tick", "share");
+    for (int phase = 0; phase < GAME_PHASE_COUNT; phase++) {
+        printf("  %-16s %12.1f %7.1f%%\n", GamePhaseName((GamePhase)phase),
+               times.ns[phase] / game.tick, timed > 0 ? 100.0 * times.ns[phase] / timed : 0.0);
+    }
+    printf("  %-16s %6d of %6d alive\n", "aliens", game.formation.liveCount,
+           game.formation.rows * game.formation.cols);
+    PrintPool("player bullets", &game.playerBulletPool);
+    PrintPool("alien bullets", &game.alienBulletPool);
+    PrintPool("explosions", &game.explosionPool);
+    if (game.particles != NULL) {
+        PrintPool("particles", &game.particles->pool);
+        printf("  %-16s %s\n", "particle kernel", ParticleKernelName(game.particles->kernel));
+    }
+    DestroyGame(&game);
+    return true;
+}
+
+// Fold the result hashes of a batch in job order, the same whatever the
+// thread count
+static uint64_t BatchHash(const BatchResult* results, int count) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (int i = 0; i < count; i++) {
+        hash = (hash ^ results[i].hash) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void PrintBatchSummary(const BatchResult* results, int count) {
+    int finished[GAME_WIN + 1] = {0};
+    double score = 0, ticks = 0;
+    for (int i = 0; i < count; i++) {
+        finished[results[i].state]++;
+        score += results[i].score;
+        ticks += results[i].ticks;
+    }
+    printf("  %d won, %d lost, %d unfinished; mean score %.1f, mean length %.0f ticks\n",
+           finished[GAME_WIN], finished[GAME_OVER], count - finished[GAME_WIN] - finished[GAME_OVER],
+           score / count, ticks / count);
+    printf("  batch hash %016llx\n", (unsigned long long)BatchHash(results, count));
+}
+
+// Many games at once: scripted with consecutive seeds, or every one
+// replaying the same log, which must then end in the same state. With
+// scaling, the batch is played again on 1, 2, 4... threads up to the
+// requested count, and every run must give the same results.
+static bool RunBatchMode(int count, uint64_t seed, long ticks, const InputLog* replay, int threads, bool scaling) {
+    BatchJob* jobs = malloc(sizeof(BatchJob) * (size_t)count);
+    BatchResult* results = malloc(sizeof(BatchResult) * (size_t)count);
+    if (jobs == NULL || results == NULL) {
+        free(jobs);
+        free(results);
+        fprintf(stderr, "not enough memory for %d games\n", count);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        jobs[i].seed = seed + (uint64_t)i;
+        jobs[i].input = replay != NULL ? BATCH_INPUT_REPLAY : BATCH_INPUT_SCRIPTED;
+        jobs[i].replay = replay;
+        jobs[i].maxTicks = ticks;
+    }
+    if (threads <= 0) {
+        threads = BatchDefaultThreads();
+    }
+    GameConfig config;
+    DefaultGameConfig(&config);
+
+    if (replay != NULL) {
+        printf("batch: %d replays of one log (seed %llu, %u ticks)\n",
+               count, (unsigned long long)replay->seed, replay->endTick);
+    } else {
+        printf("batch: %d scripted games, seeds %llu to %llu, up to %ld ticks each\n",
+               count, (unsigned long long)seed, (unsigned long long)(seed + count - 1), ticks);
+    }
+    printf("  %7s %12s %14s %8s %8s\n", "threads", "games/s", "ticks/s", "speedup", "steals");
+
+    bool ok = true;
+    uint64_t expected = 0;
+    double baseline = 0;
+    int runThreads = scaling ? 1 : threads;
+    while (ok) {
+        BatchStats stats;
+        double start = NowNs();
+        if (!RunBatch(&config, jobs, results, count, runThreads, &stats)) {
+            fprintf(stderr, "could not start the batch on %d threads\n", runThreads);
+            ok = false;
+            break;
+        }
+        double seconds = (NowNs() - start) / 1e9;
+        if (baseline == 0) {
+            baseline = seconds;
+        }
+        printf("  %7d %12.1f %14.0f %7.2fx %8d\n", stats.threads, count / seconds, stats.ticks / seconds,
+               baseline / seconds, stats.steals);
+
+        uint64_t hash = BatchHash(results, count);
+        if (expected == 0) {
+            expected = hash;
+        } else if (hash != expected) {
+            fprintf(stderr, "results on %d threads differ from the first run\n", runThreads);
+            ok = false;
+        }
+        if (runThreads >= threads) {
+            break;
+        }
+        runThreads = runThreads * 2 < threads ? runThreads * 2 : threads;
+    }
+
+    if (ok) {
+        PrintBatchSummary(results, count);
+    }
+    for (int i = 1; i < count && ok && replay != NULL; i++) {
+        if (results[i].hash != results[0].hash) {
+            fprintf(stderr, "replay %d ended in a different state\n", i);
+            ok = false;
+        }
+    }
+    if (ok && replay != NULL) {
+        printf("  every replay ended with state hash %016llx\n", (unsigned long long)results[0].hash);
+    }
+    free(jobs);
+    free(results);
+    return ok;
+}
+
+static int CompareInts(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentiles of values, sorted in place; nothing is printed for no values
+static void PrintDistribution(const char* name, int* values, int count) {
+    if (count == 0) {
+        printf("  %-14s %8s\n", name, "-");
+        return;
+    }
+    qsort(values, (size_t)count, sizeof(int), CompareInts);
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    printf("  %-14s %8d %8d %8d %8d %8d %10.1f\n", name, values[0], values[(count - 1) / 10],
+           values[(count - 1) / 2], values[(count - 1) * 9 / 10], values[count - 1], sum / count);
+}
+
+// Autopilot games in parallel, summarized per level: how many games got
+// there, how many cleared it and how long clearing took
+static bool RunTournament(int count, uint64_t seed, long ticks, const Scenario* scenario, int threads) {
+    BatchJob* jobs = malloc(sizeof(BatchJob) * (size_t)count);
+    BatchResult* results = malloc(sizeof(BatchResult) * (size_t)count);
+    int* values = malloc(sizeof(int) * (size_t)count);
+    if (jobs == NULL || results == NULL || values == NULL) {
+        free(jobs);
+        free(results);
+        free(values);
+        fprintf(stderr, "not enough memory for %d games\n", count);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        jobs[i].seed = seed + (uint64_t)i;
+        jobs[i].input = BATCH_INPUT_AUTOPILOT;
+        jobs[i].replay = NULL;
+        jobs[i].maxTicks = ticks;
+    }
+
+    BatchStats stats;
+    double start = NowNs();
+    if (!RunBatch(&scenario->config, jobs, results, count, threads, &stats)) {
+        fprintf(stderr, "could not start the tournament\n");
+        free(jobs);
+        free(results);
+        free(values);
+        return false;
+    }
+    double seconds = (NowNs() - start) / 1e9;
+
+    const GameConfig* config = &scenario->config;
+    printf("tournament %s: %d autopilot games, seeds %llu to %llu, %d levels\n", scenario->name, count,
+           (unsigned long long)seed, (unsigned long long)(seed + count - 1), config->levels);
+    printf("  %.2f s on %d threads, %.1f games/s, %.0f ticks/s\n",
+           seconds, stats.threads, count / seconds, stats.ticks / seconds);
+    printf("  %-6s %8s %8s %9s %10s %10s %10s\n", "level", "reached", "cleared", "survival",
+           "clear p10", "clear p50", "clear p90");
+    for (int level = 1; level <= config->levels; level++) {
+        int reached = 0, cleared = 0;
+        for (int i = 0; i < count; i++) {
+            if (results[i].levelsCleared >= level - 1) reached++;
+            if (results[i].levelsCleared >= level) values[cleared++] = (int)results[i].clearTicks[level - 1];
+        }
+        if (reached == 0) {
+            break;
+        }
+        qsort(values, (size_t)cleared, sizeof(int), CompareInts);
+        printf("  %-6d %8d %8d %8.1f%%", level, reached, cleared, 100.0 * cleared / reached);
+        if (cleared > 0) {
+            printf(" %10d %10d %10d\n", values[(cleared - 1) / 10], values[(cleared - 1) / 2],
+                   values[(cleared - 1) * 9 / 10]);
+        } else {
+            printf(" %10s %10s %10s\n", "-", "-", "-");
+        }
+    }
+
+    int won = 0, lost = 0;
+    for (int i = 0; i < count; i++) {
+        won += results[i].state == GAME_WIN;
+        lost += results[i].state == GAME_OVER;
+    }
+    printf("  %d won (%.1f%%), %d lost, %d still playing after %ld ticks\n",
+           won, 100.0 * won / count, lost, count - won - lost, ticks);
+    printf("  %-14s %8s %8s %8s %8s %8s %10s\n", "", "min", "p10", "p50", "p90", "max", "mean");
+    for (int i = 0; i < count; i++) {
+        values[i] = results[i].score;
+    }
+    PrintDistribution("score", values, count);
+    for (int i = 0; i < count; i++) {
+        values[i] = (int)results[i].ticks;
+    }
+    PrintDistribution("game ticks", values, count);
+
+    free(jobs);
+    free(results);
+    free(values);
+    return true;
+}
+
+// Synthetic keyboard: random presses, some released before the next tick,
+// held keys repeating the way the OS autorepeat does
+#define SYNTHETIC_REPEAT_DELAY_NS 500000000LL
+#define SYNTHETIC_REPEAT_NS 33000000LL
+
+typedef struct {
+    GameInput key;
+    bool down;
+    int64_t nextNs;   // next press, or release while down
+    int64_t repeatNs; // next autorepeat while down
+} SyntheticKey;
+
+// Sample the keys for the tick due at nowNs, and run it
+static void TickWithKeys(Game* game, InputState* input, int64_t nowNs) {
+    GameInput inputs[MAX_PENDING_INPUTS];
+    int count = SampleInputState(input, nowNs, inputs);
+    for (int i = 0; i < count; i++) {
+        QueueInput(game, inputs[i]);
+    }
+    UpdateGame(game);
+}
+
+// Key events up to a time for one synthetic key. A key is never pressed
+// again within a tick of its release, so every press gets its own sample
+// unless the loop stalls; a press that finds the previous one still
+// latched merges into it and is counted apart.
+static long FeedSyntheticKey(SyntheticKey* key, InputState* input, Rng* rng, int64_t untilNs,
+                             int64_t tickNs, long* taps, long* merged) {
+    long presses = 0;
+    for (;;) {
+        if (key->down && key->repeatNs < key->nextNs && key->repeatNs <= untilNs) {
+            PressKey(input, key->key, key->repeatNs);
+            key->repeatNs += SYNTHETIC_REPEAT_NS;
+        } else if (key->nextNs > untilNs) {
+            return presses;
+        } else if (key->down) {
+            ReleaseKey(input, key->key);
+            key->down = false;
+            key->nextNs += tickNs + RandomRange(rng, 200) * 1000000LL;
+        } else {
+            if (input->pressed & (1 << key->key)) {
+                (*merged)++;
+            } else {
+                presses++;
+            }
+            PressKey(input, key->key, key->nextNs);
+            key->down = true;
+            int64_t hold = RandomRange(rng, 4) == 0 ? 1 + RandomRange(rng, (int)(tickNs / 2))
+                                                     : (20 + RandomRange(rng, 400)) * 1000000LL;
+            if (hold < tickNs) {
+                (*taps)++;
+            }
+            key->repeatNs = key->nextNs + SYNTHETIC_REPEAT_DELAY_NS;
+            key->nextNs += hold;
+        }
+    }
+}
+
+// When a synthetic key next does something
+static int64_t NextKeyEventNs(const SyntheticKey* key) {
+    return key->down && key->repeatNs < key->nextNs ? key->repeatNs : key->nextNs;
+}
+
+// How far one second of holding right moves the ship at a tick rate, with
+// an autorepeat that must change nothing
+static int HeldKeyDistance(Game* game, uint64_t seed, int tickRate) {
+    int64_t tickNs = NS_PER_SECOND / tickRate;
+    InputState input;
+    InitInputState(&input, tickNs);
+    SeedGame(game, seed);
+    InitializeGame(game);
+
+    // Tap fire to leave the menu
+    int64_t now = 0;
+    PressKey(&input, INPUT_FIRE, now + 1000000);
+    ReleaseKey(&input, INPUT_FIRE);
+    now += tickNs;
+    TickWithKeys(game, &input, now);
+    int startX = game->playerX;
+    PressKey(&input, INPUT_RIGHT, now + 1);
+    for (int t = 0; t < tickRate; t++) {
+        PressKey(&input, INPUT_RIGHT, now + 2);
+        now += tickNs;
+        TickWithKeys(game, &input, now);
+    }
+    ReleaseKey(&input, INPUT_RIGHT);
+    now += tickNs;
+    TickWithKeys(game, &input, now);
+    return game->playerX - startX;
+}
+
+// The loop wakes a little after it meant to, and now and then a lot after
+#define LATENCY_OVERSLEEP_NS 2000000
+#define LATENCY_STALL_ODDS 100
+#define LATENCY_STALL_TICKS 2
+
+// Drive the per-tick input sampling with a synthetic keyboard on a fake
+// 60 Hz clock. Presses land at random times across the run and reach the
+// input state when the loop next wakes, for a key event or a due tick, late
+// by a random oversleep and sometimes by a stall of a few ticks, like the
+// message pump in main.c; every due tick then runs and samples at the time
+// the loop woke, as main.c does. A press can then never be sampled before
+// it happened, nor wait longer than the longest gap between two wakes that
+// ran ticks unless the sampler drops or defers it, and it is on average
+// about half a tick late. Held movement must cover the same distance per
+// second at any tick rate.
+static bool RunInputLatency(uint64_t seed, long ticks) {
+    static Game game;
+    GameConfig config;
+    DefaultGameConfig(&config);
+    if (!CreateGame(&game, &config)) {
+        return false;
+    }
+    bool ok = true;
+
+    static const int rates[] = {30, 60, 144, 240};
+    int distances[4];
+    int expected = INPUT_MOVE_RATE * config.playerSpeed;
+    for (int r = 0; r < 4; r++) {
+        distances[r] = HeldKeyDistance(&game, seed, rates[r]);
+        if (abs(distances[r] - expected) > config.playerSpeed) {
+            ok = false;
+        }
+    }
+
+    // Random presses on left, right and fire
+    SeedGame(&game, seed);
+    InitializeGame(&game);
+    int64_t tickNs = NS_PER_SECOND / DEFAULT_TICK_RATE;
+    InputState input;
+    InitInputState(&input, tickNs);
+    Rng rng;
+    SeedRandom(&rng, seed, 1);
+    SyntheticKey keys[] = {
+        {INPUT_LEFT, false, RandomRange(&rng, 200) * 1000000LL, 0},
+        {INPUT_RIGHT, false, RandomRange(&rng, 200) * 1000000LL, 0},
+        {INPUT_FIRE, false, RandomRange(&rng, 200) * 1000000LL, 0},
+    };
+    int keyCount = (int)(sizeof(keys) / sizeof(keys[0]));
+    long presses = 0, taps = 0, merged = 0, wakes = 0, ran = 0;
+    int64_t now = 0, nextDue = tickNs, lastSampled = 0, longestGap = 0;
+    while (ran < ticks) {
+        int64_t wake = nextDue;
+        for (int k = 0; k < keyCount; k++) {
+            int64_t event = NextKeyEventNs(&keys[k]);
+            if (event < wake) {
+                wake = event;
+            }
+        }
+        wake += RandomRange(&rng, LATENCY_OVERSLEEP_NS);
+        if (RandomRange(&rng, LATENCY_STALL_ODDS) == 0) {
+            wake += RandomRange(&rng, (int)(LATENCY_STALL_TICKS * tickNs));
+        }
+        now = wake > now ? wake : now;
+        wakes++;
+
+        for (int k = 0; k < keyCount; k++) {
+            presses += FeedSyntheticKey(&keys[k], &input, &rng, now, tickNs, &taps, &merged);
+        }
+        if (nextDue <= now) {
+            if (now - lastSampled > longestGap) {
+                longestGap = now - lastSampled;
+            }
+            lastSampled = now;
+        }
+        while (nextDue <= now && ran < ticks) {
+            TickWithKeys(&game, &input, now);
+            nextDue += tickNs;
+            ran++;
+        }
+    }
+    TickWithKeys(&game, &input, now); // presses fed after the last tick
+    if (now - lastSampled > longestGap) {
+        longestGap = now - lastSampled;
+    }
+
+    const PacingStats* latency = &input.latency;
+    printf("synthetic input: seed %llu, %ld ticks at %d Hz, %ld wakes\n", (unsigned long long)seed, ticks,
+           DEFAULT_TICK_RATE, wakes);
+    printf("  right held for a second moved the ship");
+    for (int r = 0; r < 4; r++) {
+        printf(" %d px at %d Hz%s", distances[r], rates[r], r < 3 ? "," : "");
+    }
+    printf(", expected %d\n", expected);
+    printf("  %ld presses, %ld of them taps shorter than a tick, %ld sampled, %ld more merged during stalls\n",
+           presses, taps, latency->count, merged);
+    printf("  press to sampling tick: mean %.2f ms, jitter %.2f ms, min %.2f ms, max %.2f ms (tick %.2f ms, "
+           "longest wait between ticks %.2f ms)\n",
+           latency->meanNs / 1e6, PacingJitterNs(latency) / 1e6, latency->minNs / 1e6, latency->maxNs / 1e6,
+           tickNs / 1e6, longestGap / 1e6);
+    if (!ok) {
+        printf("  FAIL: held movement speed depends on the tick rate\n");
+    }
+    if (latency->count != presses) {
+        printf("  FAIL: %ld presses never reached the simulation\n", presses - latency->count);
+        ok = false;
+    }
+    if (latency->count > 0 && latency->minNs < 0) {
+        printf("  FAIL: a press was sampled before it happened\n");
+        ok = false;
+    }
+    if (latency->count > 0 && latency->maxNs > longestGap) {
+        printf("  FAIL: a press waited past the tick after it\n");
+        ok = false;
+    }
+    if (latency->count > 0 && (latency->meanNs < tickNs * 0.35 || latency->meanNs > tickNs * 0.65)) {
+        printf("  FAIL: presses are not taken half a tick late on average\n");
+        ok = false;
+    }
+    DestroyGame(&game);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    static Game game;
+    uint64_t seed = 1;
+    long ticks = 0;
+    int step = 1;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    const char* scenarioPaths[MAX_SCENARIOS];
+    int scenarioCount = 0;
+    int batchCount = 0;
+    int tournamentCount = 0;
+    int threads = 0;
+    bool scaling = false;
+    bool inputLatency = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            step = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc && scenarioCount < MAX_SCENARIOS) {
+            scenarioPaths[scenarioCount++] = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tournament") == 0 && i + 1 < argc) {
+            tournamentCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            scaling = true;
+        } else if (strcmp(argv[i], "--input-latency") == 0) {
+            inputLatency = true;
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Inputs land on the first tick of each update, so a stepped session
+    // cannot be recorded or replayed tick for tick
+    if (step < 1 || (step > 1 && (recordPath != NULL || replayPath != NULL))) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    // Synthetic keyboard, nothing recorded
+    if (inputLatency) {
+        if (scenarioCount > 0 || batchCount > 0 || tournamentCount > 0 || step > 1 ||
+            recordPath != NULL || replayPath != NULL) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        return RunInputLatency(seed, ticks > 0 ? ticks : DEFAULT_TICKS) ? 0 : 1;
+    }
+
+    // Autopilot tournament on the classic game or one scenario
+    if (tournamentCount > 0) {
+        Scenario scenario;
+        char error[256];
+        if (scenarioCount > 1 || step > 1 || recordPath != NULL || replayPath != NULL) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        if (scenarioCount == 0) {
+            DefaultScenario(&scenario);
+        } else if (!LoadScenario(&scenario, scenarioPaths[0], error, sizeof(error))) {
+            fprintf(stderr, "%s: %s\n", scenarioPaths[0], error);
+            return 1;
+        }
+        return RunTournament(tournamentCount, seed, ticks > 0 ? ticks : TOURNAMENT_TICKS, &scenario, threads) ? 0 : 1;
+    }
+
+    // Scenarios one after another, each for its own tick count unless
+    // --ticks overrides it
+    if (scenarioCount > 0) {
+        for (int i = 0; i < scenarioCount; i++) {
+            Scenario scenario;
+            char error[256];
+            if (!LoadScenario(&scenario, scenarioPaths[i], error, sizeof(error))) {
+                fprintf(stderr, "%s: %s\n", scenarioPaths[i], error);
+                return 1;
+            }
+            if (i > 0) {
+                printf("\n");
+            }
+            if (!RunScenario(&scenario, ticks > 0 ? ticks : scenario.ticks, step)) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // Batches of independent games, nothing recorded
+    if (batchCount > 0) {
+        if (recordPath != NULL || step > 1) {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        InputLog log;
+        if (replayPath != NULL && !LoadInputLog(&log, replayPath)) {
+            fprintf(stderr, "could not read input log %s\n", replayPath);
+            return 1;
+        }
+
+        // Replays run to the end of their log unless --ticks says otherwise
+        long limit = ticks > 0 ? ticks : (replayPath != NULL ? (long)UINT32_MAX : DEFAULT_TICKS);
+        bool ok = RunBatchMode(batchCount, seed, limit, replayPath != NULL ? &log : NULL, threads, scaling);
+        if (replayPath != NULL) {
+            FreeInputLog(&log);
+        }
+        return ok ? 0 : 1;
+    }
+
+    if (ticks <= 0) {
+        ticks = DEFAULT_TICKS;
+    }
+
+    // The classic game
+    GameConfig config;
+    DefaultGameConfig(&config);
+    if (!CreateGame(&game, &config)) {
+        return 1;
+    }
+
+    // Replay: the log carries the seed and every input
+    if (replayPath != NULL) {
+        InputLog log;
+        if (!LoadInputLog(&log, replayPath)) {
+            fprintf(stderr, "could not read input log %s\n", replayPath);
+            return 1;
+        }
+
+        SeedGame(&game, log.seed);
+        InitializeGame(&game);
+        ReplayCursor cursor;
+        StartReplay(&cursor, &log);
+
+        double start = NowNs();
+        while (QueueReplayInputs(&cursor, &game)) {
+            UpdateGame(&game);
+        }
+        double elapsed = NowNs() - start;
+
+        printf("replayed %s: seed %llu, %d inputs\n", replayPath, (unsigned long long)log.seed, log.count);
+        PrintResult(&game, elapsed);
+        FreeInputLog(&log);
+        DestroyGame(&game);
+        return 0;
+    }
+
+    // Scripted session, optionally recorded
+    InputLog log;
+    SeedGame(&game, seed);
+    InitializeGame(&game);
+    InitInputLog(&log, seed);
+    game.stepTicks = step;
+
+    double start = NowNs();
+    while (game.tick < (uint32_t)ticks) {
+        GameInput inputs[MAX_PENDING_INPUTS];
+        int count = ScriptedInputs(&game, inputs);
+        for (int i = 0; i < count; i++) {
+            if (QueueInput(&game, inputs[i]) && recordPath != NULL) {
+                RecordInput(&log, game.tick, inputs[i]);
+            }
+        }
+        UpdateGame(&game);
+    }
+    double elapsed = NowNs() - start;
+    log.endTick = game.tick;
+
+    printf("scripted session: seed %llu\n", (unsigned long long)seed);
+    PrintResult(&game, elapsed);
+
+    int result = 0;
+    if (recordPath != NULL) {
+        if (SaveInputLog(&log, recordPath)) {
+            printf("recorded %d inputs to %s\n", log.count, recordPath);
+        } else {
+            fprintf(stderr, "could not write input log %s\n", recordPath);
+            result = 1;
+        }
+    }
+    FreeInputLog(&log);
+    DestroyGame(&game);
+    return result;
+}
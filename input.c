@@ -0,0 +1,266 @@
+#include "input.h"
+#include "varint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Start an empty log for a session
+void InitInputLog(InputLog* log, uint64_t seed) {
+    log->seed = seed;
+    log->endTick = 0;
+    log->events = NULL;
+    log->count = 0;
+    log->capacity = 0;
+}
+
+// Free the events
+void FreeInputLog(InputLog* log) {
+    free(log->events);
+    log->events = NULL;
+    log->count = 0;
+    log->capacity = 0;
+}
+
+// Append an input; ticks must not go backwards
+bool RecordInput(InputLog* log, uint32_t tick, GameInput input) {
+    if (log->count > 0 && tick < log->events[log->count - 1].tick) {
+        return false;
+    }
+    if (log->count == log->capacity) {
+        int capacity = log->capacity == 0 ? 256 : log->capacity * 2;
+        InputEvent* events = realloc(log->events, capacity * sizeof(InputEvent));
+        if (events == NULL) {
+            return false;
+        }
+        log->events = events;
+        log->capacity = capacity;
+    }
+    log->events[log->count].tick = tick;
+    log->events[log->count].input = (uint8_t)input;
+    log->count++;
+    if (tick > log->endTick) {
+        log->endTick = tick;
+    }
+    return true;
+}
+
+// Number of bytes EncodeInputLog needs
+size_t EncodedInputLogSize(const InputLog* log) {
+    size_t size = INPUT_LOG_HEADER_SIZE;
+    uint32_t previous = 0;
+    for (int i = 0; i < log->count; i++) {
+        size += VarintSize(((uint64_t)(log->events[i].tick - previous) << 3) | log->events[i].input);
+        previous = log->events[i].tick;
+    }
+    size += VarintSize(((uint64_t)(log->endTick - previous) << 3) | INPUT_LOG_END);
+    return size;
+}
+
+// Serialize the log, returns the number of bytes written or 0 if it doesn't fit
+size_t EncodeInputLog(const InputLog* log, uint8_t* buffer, size_t capacity) {
+    if (capacity < EncodedInputLogSize(log)) {
+        return 0;
+    }
+
+    size_t size = 0;
+    memcpy(buffer, INPUT_LOG_MAGIC, 4);
+    size += 4;
+    buffer[size++] = INPUT_LOG_VERSION;
+    for (int i = 0; i < 8; i++) {
+        buffer[size++] = (uint8_t)(log->seed >> (i * 8));
+    }
+
+    uint32_t previous = 0;
+    for (int i = 0; i < log->count; i++) {
+        size += WriteVarint(buffer + size, ((uint64_t)(log->events[i].tick - previous) << 3) | log->events[i].input);
+        previous = log->events[i].tick;
+    }
+    size += WriteVarint(buffer + size, ((uint64_t)(log->endTick - previous) << 3) | INPUT_LOG_END);
+    return size;
+}
+
+// Parse a serialized log into an empty one
+bool DecodeInputLog(InputLog* log, const uint8_t* data, size_t size) {
+    if (size < INPUT_LOG_HEADER_SIZE || memcmp(data, INPUT_LOG_MAGIC, 4) != 0 ||
+        data[4] != INPUT_LOG_VERSION) {
+        return false;
+    }
+
+    uint64_t seed = 0;
+    for (int i = 0; i < 8; i++) {
+        seed |= (uint64_t)data[5 + i] << (i * 8);
+    }
+    InitInputLog(log, seed);
+
+    size_t offset = INPUT_LOG_HEADER_SIZE;
+    uint32_t tick = 0;
+    for (;;) {
+        uint64_t record;
+        if (!ReadVarint(data, size, &offset, &record)) {
+            FreeInputLog(log);
+            return false;
+        }
+        tick += (uint32_t)(record >> 3);
+        int input = (int)(record & 7);
+        if (input == INPUT_LOG_END) {
+            log->endTick = tick;
+            return true;
+        }
+        if (input >= INPUT_COUNT || !RecordInput(log, tick, (GameInput)input)) {
+            FreeInputLog(log);
+            return false;
+        }
+    }
+}
+
+// Write a log to disk
+bool SaveInputLog(const InputLog* log, const char* path) {
+    size_t capacity = EncodedInputLogSize(log);
+    uint8_t* buffer = malloc(capacity);
+    if (buffer == NULL) {
+        return false;
+    }
+
+    size_t size = EncodeInputLog(log, buffer, capacity);
+    FILE* file = fopen(path, "wb");
+    bool ok = file != NULL && fwrite(buffer, 1, size, file) == size;
+    if (file != NULL && fclose(file) != 0) {
+        ok = false;
+    }
+    free(buffer);
+    return ok;
+}
+
+// Read a log from disk
+bool LoadInputLog(InputLog* log, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    size_t capacity = 4096;
+    size_t size = 0;
+    uint8_t* data = malloc(capacity);
+    while (data != NULL) {
+        size += fread(data + size, 1, capacity - size, file);
+        if (size < capacity) {
+            break;
+        }
+        capacity *= 2;
+        uint8_t* grown = realloc(data, capacity);
+        if (grown == NULL) {
+            free(data);
+            data = NULL;
+        } else {
+            data = grown;
+        }
+    }
+    fclose(file);
+
+    bool ok = data != NULL && DecodeInputLog(log, data, size);
+    free(data);
+    return ok;
+}
+
+// Begin replaying a log; the game must be seeded with log->seed first
+void StartReplay(ReplayCursor* cursor, const InputLog* log) {
+    cursor->log = log;
+    cursor->next = 0;
+}
+
+// Queue the inputs recorded for the game's current tick. Returns false once
+// the game has reached the end of the recording.
+bool QueueReplayInputs(ReplayCursor* cursor, Game* game) {
+    const InputLog* log = cursor->log;
+    while (cursor->next < log->count && log->events[cursor->next].tick == game->tick) {
+        QueueInput(game, (GameInput)log->events[cursor->next].input);
+        cursor->next++;
+    }
+    return game->tick < log->endTick;
+}
+
+// Scripted player: sweeps the ship across the screen, fires regularly and
+// restarts from the menu, so every part of the simulation gets exercised
+int ScriptedInputs(const Game* game, GameInput* inputs) {
+    int count = 0;
+    if (game->state == GAME_PLAYING) {
+        int phase = (int)(game->tick / 90) % 2;
+        inputs[count++] = phase == 0 ? INPUT_RIGHT : INPUT_LEFT;
+        if (game->tick % 7 == 0) {
+            inputs[count++] = INPUT_FIRE;
+        }
+    } else {
+        inputs[count++] = INPUT_FIRE;
+    }
+    return count;
+}
+
+void InitInputState(InputState* state, int64_t tickNs) {
+    memset(state, 0, sizeof(InputState));
+    state->tickNs = tickNs;
+}
+
+// A key that is already down is the OS repeating it, not a new press
+void PressKey(InputState* state, GameInput key, int64_t nowNs) {
+    uint8_t bit = (uint8_t)(1 << key);
+    if (state->down & bit) {
+        return;
+    }
+    state->down |= bit;
+    if (!(state->pressed & bit)) {
+        state->pressed |= bit;
+        state->pressedNs[key] = nowNs;
+    }
+}
+
+void ReleaseKey(InputState* state, GameInput key) {
+    state->down &= (uint8_t)~(1 << key);
+}
+
+// Nothing stays held once the window loses the keyboard
+void ReleaseAllKeys(InputState* state) {
+    state->down = 0;
+}
+
+// Steps of a movement key for the tick about to run: one on a fresh press,
+// then one per INPUT_MOVE_INTERVAL_NS held, at most room of them (room is
+// never zero)
+static int SampleMove(InputState* state, GameInput key, GameInput* inputs, int room) {
+    int64_t* credit = &state->moveCreditNs[key == INPUT_RIGHT];
+    uint8_t bit = (uint8_t)(1 << key);
+    if (state->pressed & bit) {
+        *credit = 0;
+        inputs[0] = key;
+        return 1;
+    }
+    if (!(state->down & bit)) {
+        *credit = 0;
+        return 0;
+    }
+    int count = 0;
+    *credit += state->tickNs;
+    while (*credit >= INPUT_MOVE_INTERVAL_NS && count < room) {
+        *credit -= INPUT_MOVE_INTERVAL_NS;
+        inputs[count++] = key;
+    }
+    *credit %= INPUT_MOVE_INTERVAL_NS;
+    return count;
+}
+
+// The inputs for the tick about to run, at most MAX_PENDING_INPUTS of them
+int SampleInputState(InputState* state, int64_t nowNs, GameInput* inputs) {
+    int room = MAX_PENDING_INPUTS - 2; // fire and escape
+    int count = SampleMove(state, INPUT_LEFT, inputs, room / 2);
+    count += SampleMove(state, INPUT_RIGHT, inputs + count, room / 2);
+    if (state->pressed & (1 << INPUT_FIRE)) inputs[count++] = INPUT_FIRE;
+    if (state->pressed & (1 << INPUT_ESCAPE)) inputs[count++] = INPUT_ESCAPE;
+
+    for (int key = 0; key < INPUT_COUNT; key++) {
+        if (state->pressed & (1 << key)) {
+            RecordPacing(&state->latency, nowNs - state->pressedNs[key]);
+        }
+    }
+    state->pressed = 0;
+    return count;
+}
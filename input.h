@@ -0,0 +1,80 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "loop.h"
+
+// Binary input log: "SIRP", version byte, 64-bit seed, then one varint per
+// event holding (ticks since previous event << 3 | input). The log ends
+// with an INPUT_LOG_END record placed on the tick the session stopped.
+#define INPUT_LOG_MAGIC "SIRP"
+#define INPUT_LOG_VERSION 1
+#define INPUT_LOG_END 7
+#define INPUT_LOG_HEADER_SIZE 13
+#define INPUT_LOG_MAX_RECORD_SIZE 5
+
+// One recorded input
+typedef struct {
+    uint32_t tick;
+    uint8_t input; // GameInput
+} InputEvent;
+
+// Inputs of one session, keyed by tick number
+typedef struct {
+    uint64_t seed;
+    uint32_t endTick;
+    InputEvent* events;
+    int count;
+    int capacity;
+} InputLog;
+
+// Position of a replay inside a log
+typedef struct {
+    const InputLog* log;
+    int next;
+} ReplayCursor;
+
+void InitInputLog(InputLog* log, uint64_t seed);
+void FreeInputLog(InputLog* log);
+bool RecordInput(InputLog* log, uint32_t tick, GameInput input);
+
+size_t EncodedInputLogSize(const InputLog* log);
+size_t EncodeInputLog(const InputLog* log, uint8_t* buffer, size_t capacity);
+bool DecodeInputLog(InputLog* log, const uint8_t* data, size_t size);
+bool SaveInputLog(const InputLog* log, const char* path);
+bool LoadInputLog(InputLog* log, const char* path);
+
+void StartReplay(ReplayCursor* cursor, const InputLog* log);
+bool QueueReplayInputs(ReplayCursor* cursor, Game* game);
+
+int ScriptedInputs(const Game* game, GameInput* inputs);
+
+// Keyboard state, one bit per GameInput, fed by key events as they come and
+// sampled once per tick. A held left or right steps the ship on the press,
+// then INPUT_MOVE_RATE times per second of ticks, the speed the OS
+// autorepeat used to give it but without its initial delay and whatever
+// the tick rate; fire and escape act once per press. A press is latched
+// until the next sample, so a tap shorter than a tick still counts.
+#define INPUT_MOVE_RATE 30
+#define INPUT_MOVE_INTERVAL_NS (NS_PER_SECOND / INPUT_MOVE_RATE)
+
+typedef struct {
+    int64_t tickNs;                 // simulated time per sample
+    uint8_t down;                   // held right now
+    uint8_t pressed;                // went down since the last sample
+    int64_t pressedNs[INPUT_COUNT]; // when each latched press happened
+    int64_t moveCreditNs[2];        // held time not yet stepped, left and right
+    PacingStats latency;            // from a press to the tick that sampled it
+} InputState;
+
+void InitInputState(InputState* state, int64_t tickNs);
+void PressKey(InputState* state, GameInput key, int64_t nowNs);
+void ReleaseKey(InputState* state, GameInput key);
+void ReleaseAllKeys(InputState* state);
+int SampleInputState(InputState* state, int64_t nowNs, GameInput* inputs);
+
+#endif
@@ -0,0 +1,98 @@
+#include "loop.h"
+
+#include <math.h>
+#include <stdio.h>
+
+// Record one frame interval, or any other duration kept the same way
+void RecordPacing(PacingStats* stats, int64_t intervalNs) {
+    stats->count++;
+    if (stats->count == 1) {
+        stats->minNs = intervalNs;
+        stats->maxNs = intervalNs;
+    } else {
+        if (intervalNs < stats->minNs) stats->minNs = intervalNs;
+        if (intervalNs > stats->maxNs) stats->maxNs = intervalNs;
+    }
+
+    double delta = intervalNs - stats->meanNs;
+    stats->meanNs += delta / stats->count;
+    stats->m2 += delta * (intervalNs - stats->meanNs);
+}
+
+// Initialize the loop for a given simulation rate in ticks per second
+void InitFixedLoop(FixedLoop* loop, int tickRate, int maxCatchUpTicks) {
+    if (tickRate <= 0) tickRate = DEFAULT_TICK_RATE;
+    if (maxCatchUpTicks <= 0) maxCatchUpTicks = 1;
+
+    loop->tickRate = tickRate;
+    loop->tickNs = NS_PER_SECOND / tickRate;
+    loop->maxCatchUpTicks = maxCatchUpTicks;
+
+    loop->started = false;
+    loop->lastNs = 0;
+    loop->accumulatorNs = 0;
+
+    loop->frames = 0;
+    loop->ticks = 0;
+    loop->droppedTicks = 0;
+    loop->cappedFrames = 0;
+
+    loop->pacing.count = 0;
+    loop->pacing.meanNs = 0;
+    loop->pacing.m2 = 0;
+    loop->pacing.minNs = 0;
+    loop->pacing.maxNs = 0;
+}
+
+// Feed the current time and get the number of ticks to simulate this frame
+int AdvanceFixedLoop(FixedLoop* loop, int64_t nowNs) {
+    if (!loop->started) {
+        loop->started = true;
+        loop->lastNs = nowNs;
+        return 0;
+    }
+
+    int64_t frameNs = nowNs - loop->lastNs;
+    loop->lastNs = nowNs;
+    if (frameNs < 0) frameNs = 0;
+
+    loop->frames++;
+    RecordPacing(&loop->pacing, frameNs);
+
+    loop->accumulatorNs += frameNs;
+    int64_t due = loop->accumulatorNs / loop->tickNs;
+
+    // Spiral of death: never try to catch up more than the cap, drop the rest
+    if (due > loop->maxCatchUpTicks) {
+        loop->droppedTicks += (long)(due - loop->maxCatchUpTicks);
+        loop->cappedFrames++;
+        loop->accumulatorNs -= (due - loop->maxCatchUpTicks) * loop->tickNs;
+        due = loop->maxCatchUpTicks;
+    }
+
+    loop->accumulatorNs -= due * loop->tickNs;
+    loop->ticks += (long)due;
+    return (int)due;
+}
+
+// How far between the last tick and the next one the render time is (0..1)
+double FixedLoopAlpha(const FixedLoop* loop) {
+    return (double)loop->accumulatorNs / (double)loop->tickNs;
+}
+
+// Standard deviation of the frame interval
+double PacingJitterNs(const PacingStats* stats) {
+    if (stats->count < 2) return 0.0;
+    return sqrt(stats->m2 / (stats->count - 1));
+}
+
+// One line summary, e.g. for the window title
+int FormatLoopStats(const FixedLoop* loop, char* buffer, int size) {
+    return snprintf(buffer, size,
+        "sim %d Hz | frame %.2f ms, jitter %.2f ms, max %.2f ms | dropped %ld ticks",
+        loop->tickRate,
+        loop->pacing.meanNs / 1e6,
+        PacingJitterNs(&loop->pacing) / 1e6,
+        loop->pacing.maxNs / 1e6,
+        loop->droppedTicks);
+}
@@ -0,0 +1,57 @@
+#ifndef LOOP_H
+#define LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Simulation rate used when nothing else is configured
+#define DEFAULT_TICK_RATE 60
+// Catch-up ticks allowed per frame before the loop drops time
+#define DEFAULT_MAX_CATCH_UP 5
+
+#define NS_PER_SECOND 1000000000LL
+
+// Frame pacing statistics (Welford running mean/variance)
+typedef struct {
+    long count;
+    double meanNs;
+    double m2;
+    int64_t minNs;
+    int64_t maxNs;
+} PacingStats;
+
+// Fixed-timestep accumulator. The caller owns the clock: it passes the
+// current time in nanoseconds on every frame, so a fake clock drives it
+// exactly like QueryPerformanceCounter or CLOCK_MONOTONIC does.
+typedef struct {
+    int tickRate;
+    int64_t tickNs;
+    int maxCatchUpTicks;
+
+    bool started;
+    int64_t lastNs;
+    int64_t accumulatorNs;
+
+    // Counters
+    long frames;
+    long ticks;
+    long droppedTicks;
+    long cappedFrames;
+    PacingStats pacing;
+} FixedLoop;
+
+void RecordPacing(PacingStats* stats, int64_t intervalNs);
+
+void InitFixedLoop(FixedLoop* loop, int tickRate, int maxCatchUpTicks);
+int AdvanceFixedLoop(FixedLoop* loop, int64_t nowNs);
+double FixedLoopAlpha(const FixedLoop* loop);
+
+double PacingJitterNs(const PacingStats* stats);
+int FormatLoopStats(const FixedLoop* loop, char* buffer, int size);
+
+// Blend between the state of the previous tick and the current one
+static inline int InterpolateInt(int previous, int current, double alpha) {
+    return previous + (int)((current - previous) * alpha);
+}
+
+#endif
@@ -0,0 +1,273 @@
+#include "particles.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTICLES_X86 1
+#include <immintrin.h>
+#else
+#define PARTICLES_X86 0
+#endif
+
+#define PARTICLE_SEED 0x5eed
+
+bool CreateParticleSystem(ParticleSystem* system, int capacity) {
+    memset(system, 0, sizeof(ParticleSystem));
+    size_t bytes = sizeof(float) * (size_t)capacity;
+    system->x = malloc(bytes);
+    system->y = malloc(bytes);
+    system->vx = malloc(bytes);
+    system->vy = malloc(bytes);
+    system->life = malloc(bytes);
+    system->color = malloc(sizeof(uint32_t) * (size_t)capacity);
+    if (system->x == NULL || system->y == NULL || system->vx == NULL || system->vy == NULL ||
+        system->life == NULL || system->color == NULL) {
+        DestroyParticleSystem(system);
+        return false;
+    }
+    InitPool(&system->pool, capacity);
+    system->gravity = 0.08f;
+    system->drag = 0.96f;
+    system->kernel = BestParticleKernel();
+    SeedRandom(&system->rng, PARTICLE_SEED, 0);
+    return true;
+}
+
+void DestroyParticleSystem(ParticleSystem* system) {
+    free(system->x);
+    free(system->y);
+    free(system->vx);
+    free(system->vy);
+    free(system->life);
+    free(system->color);
+    memset(system, 0, sizeof(ParticleSystem));
+}
+
+void ClearParticles(ParticleSystem* system) {
+    system->pool.count = 0;
+}
+
+bool ParticleKernelAvailable(ParticleKernel kernel) {
+    switch (kernel) {
+        case PARTICLE_KERNEL_SCALAR:
+            return true;
+#if PARTICLES_X86
+        case PARTICLE_KERNEL_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case PARTICLE_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+// Widest kernel this CPU runs
+ParticleKernel BestParticleKernel(void) {
+    for (int kernel = PARTICLE_KERNEL_COUNT - 1; kernel > PARTICLE_KERNEL_SCALAR; kernel--) {
+        if (ParticleKernelAvailable((ParticleKernel)kernel)) {
+            return (ParticleKernel)kernel;
+        }
+    }
+    return PARTICLE_KERNEL_SCALAR;
+}
+
+const char* ParticleKernelName(ParticleKernel kernel) {
+    static const char* names[] = {"scalar", "sse2", "avx2"};
+    return kernel < PARTICLE_KERNEL_COUNT ? names[kernel] : "unknown";
+}
+
+int SpawnParticle(ParticleSystem* system, float x, float y, float vx, float vy, float life, uint32_t color) {
+    int i = AcquireSlot(&system->pool);
+    if (i < 0) {
+        return -1;
+    }
+    system->x[i] = x;
+    system->y[i] = y;
+    system->vx[i] = vx;
+    system->vy[i] = vy;
+    system->life[i] = life;
+    system->color[i] = color;
+    return i;
+}
+
+// One tick of motion for particles [begin, end), returning the first one
+// whose life ran out or firstDead if none did. The vector kernels do the
+// same operations in the same order, lane by lane.
+static int UpdateRange(ParticleSystem* system, int begin, int end, int firstDead) {
+    float* x = system->x;
+    float* y = system->y;
+    float* vx = system->vx;
+    float* vy = system->vy;
+    float* life = system->life;
+    float drag = system->drag;
+    float gravity = system->gravity;
+    for (int i = begin; i < end; i++) {
+        x[i] += vx[i];
+        y[i] += vy[i];
+        vx[i] = vx[i] * drag;
+        vy[i] = vy[i] * drag + gravity;
+        life[i] -= 1.0f;
+        if (life[i] <= 0.0f && i < firstDead) {
+            firstDead = i;
+        }
+    }
+    return firstDead;
+}
+
+#if PARTICLES_X86
+__attribute__((target("sse2")))
+static int UpdateSse2(ParticleSystem* system, int count) {
+    float* x = system->x;
+    float* y = system->y;
+    float* vx = system->vx;
+    float* vy = system->vy;
+    float* life = system->life;
+    __m128 drag = _mm_set1_ps(system->drag);
+    __m128 gravity = _mm_set1_ps(system->gravity);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 zero = _mm_setzero_ps();
+    int firstDead = count;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 velocityX = _mm_loadu_ps(vx + i);
+        __m128 velocityY = _mm_loadu_ps(vy + i);
+        __m128 remaining = _mm_sub_ps(_mm_loadu_ps(life + i), one);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), velocityX));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), velocityY));
+        _mm_storeu_ps(vx + i, _mm_mul_ps(velocityX, drag));
+        _mm_storeu_ps(vy + i, _mm_add_ps(_mm_mul_ps(velocityY, drag), gravity));
+        _mm_storeu_ps(life + i, remaining);
+        int dead = _mm_movemask_ps(_mm_cmple_ps(remaining, zero));
+        if (dead != 0 && firstDead == count) {
+            firstDead = i + __builtin_ctz((unsigned)dead);
+        }
+    }
+    return UpdateRange(system, i, count, firstDead);
+}
+
+__attribute__((target("avx2")))
+static int UpdateAvx2(ParticleSystem* system, int count) {
+    float* x = system->x;
+    float* y = system->y;
+    float* vx = system->vx;
+    float* vy = system->vy;
+    float* life = system->life;
+    __m256 drag = _mm256_set1_ps(system->drag);
+    __m256 gravity = _mm256_set1_ps(system->gravity);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 zero = _mm256_setzero_ps();
+    int firstDead = count;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 velocityX = _mm256_loadu_ps(vx + i);
+        __m256 velocityY = _mm256_loadu_ps(vy + i);
+        __m256 remaining = _mm256_sub_ps(_mm256_loadu_ps(life + i), one);
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), velocityX));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), velocityY));
+        _mm256_storeu_ps(vx + i, _mm256_mul_ps(velocityX, drag));
+        _mm256_storeu_ps(vy + i, _mm256_add_ps(_mm256_mul_ps(velocityY, drag), gravity));
+        _mm256_storeu_ps(life + i, remaining);
+        int dead = _mm256_movemask_ps(_mm256_cmp_ps(remaining, zero, _CMP_LE_OQ));
+        if (dead != 0 && firstDead == count) {
+            firstDead = i + __builtin_ctz((unsigned)dead);
+        }
+    }
+    return UpdateRange(system, i, count, firstDead);
+}
+#endif
+
+// Drop the particles that ran out of life, from the first dead one on: the
+// last live particle moves into each hole
+static void ReleaseDeadParticles(ParticleSystem* system, int first) {
+    float* x = system->x;
+    float* y = system->y;
+    float* vx = system->vx;
+    float* vy = system->vy;
+    float* life = system->life;
+    uint32_t* color = system->color;
+    int count = system->pool.count;
+    for (int i = first; i < count;) {
+        if (life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        count--;
+        x[i] = x[count];
+        y[i] = y[count];
+        vx[i] = vx[count];
+        vy[i] = vy[count];
+        life[i] = life[count];
+        color[i] = color[count];
+    }
+    system->pool.count = count;
+}
+
+// Advance every particle one tick with the selected kernel, then drop the
+// ones that ran out of life. Kernels return the first particle that died,
+// or the count when none did, so a tick without deaths skips the sweep.
+void UpdateParticles(ParticleSystem* system) {
+    int count = system->pool.count;
+    int firstDead;
+    switch (system->kernel) {
+#if PARTICLES_X86
+        case PARTICLE_KERNEL_SSE2:
+            firstDead = UpdateSse2(system, count);
+            break;
+        case PARTICLE_KERNEL_AVX2:
+            firstDead = UpdateAvx2(system, count);
+            break;
+#endif
+        default:
+            firstDead = UpdateRange(system, 0, count, count);
+            break;
+    }
+    if (firstDead < count) {
+        ReleaseDeadParticles(system, firstDead);
+    }
+}
+
+// Uniform value in [-spread, spread]
+static float RandomSpread(Rng* rng, float spread) {
+    return spread * (float)(RandomRange(rng, 2001) - 1000) / 1000.0f;
+}
+
+// Bright sparks flying out of an explosion
+void SpawnSparks(ParticleSystem* system, int x, int y) {
+    static const uint32_t colors[] = {
+        PARTICLE_RGB(255, 255, 100), // Yellow
+        PARTICLE_RGB(255, 150, 50),  // Orange
+        PARTICLE_RGB(255, 255, 255)  // White
+    };
+    if (system == NULL) {
+        return;
+    }
+    for (int i = 0; i < 24; i++) {
+        Rng* rng = &system->rng;
+        SpawnParticle(system, (float)x, (float)y, RandomSpread(rng, 3.0f), RandomSpread(rng, 3.0f),
+                      (float)(20 + RandomRange(rng, 20)), colors[RandomRange(rng, 3)]);
+    }
+}
+
+// Chips knocked off a shield
+void SpawnDebris(ParticleSystem* system, int x, int y) {
+    if (system == NULL) {
+        return;
+    }
+    for (int i = 0; i < 6; i++) {
+        Rng* rng = &system->rng;
+        SpawnParticle(system, (float)x, (float)y, RandomSpread(rng, 1.5f), RandomSpread(rng, 1.5f),
+                      (float)(30 + RandomRange(rng, 20)), PARTICLE_RGB(0, 255, 0));
+    }
+}
+
+// A short-lived speck left behind a bullet
+void SpawnTrail(ParticleSystem* system, int x, int y, uint32_t color) {
+    if (system == NULL) {
+        return;
+    }
+    Rng* rng = &system->rng;
+    SpawnParticle(system, (float)x, (float)y, RandomSpread(rng, 0.25f), 0.0f,
+                  (float)(6 + RandomRange(rng, 6)), color);
+}
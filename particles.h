@@ -0,0 +1,63 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "pool.h"
+#include "rng.h"
+
+// Plenty for the classic game in the window
+#define DEFAULT_PARTICLE_CAPACITY 16384
+
+// Particle colors, same layout as FB_RGB
+#define PARTICLE_RGB(r, g, b) ((uint32_t)(((r) << 16) | ((g) << 8) | (b)))
+
+// Update kernels, all giving bit-identical results
+typedef enum {
+    PARTICLE_KERNEL_SCALAR,
+    PARTICLE_KERNEL_SSE2,
+    PARTICLE_KERNEL_AVX2,
+    PARTICLE_KERNEL_COUNT
+} ParticleKernel;
+
+// Cosmetic particles: sparks, shield debris and bullet trails. They never
+// feed back into the game, so they are not part of its state and have their
+// own random stream.
+//
+// Particles are stored as one array per field so the update kernel streams
+// through each of them with full vector loads. Live particles stay packed
+// at the front like any other pool; a particle whose life runs out is
+// replaced by the last live one.
+struct ParticleSystem {
+    Pool pool;
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* life;      // ticks left
+    uint32_t* color;  // PARTICLE_RGB
+    float gravity;    // added to vy every tick
+    float drag;       // velocity scale every tick
+    ParticleKernel kernel;
+    Rng rng;
+};
+
+bool CreateParticleSystem(ParticleSystem* system, int capacity);
+void DestroyParticleSystem(ParticleSystem* system);
+void ClearParticles(ParticleSystem* system);
+
+bool ParticleKernelAvailable(ParticleKernel kernel);
+ParticleKernel BestParticleKernel(void);
+const char* ParticleKernelName(ParticleKernel kernel);
+
+int SpawnParticle(ParticleSystem* system, float x, float y, float vx, float vy, float life, uint32_t color);
+void UpdateParticles(ParticleSystem* system);
+
+// Effects, each a no-op on a NULL system
+void SpawnSparks(ParticleSystem* system, int x, int y);
+void SpawnDebris(ParticleSystem* system, int x, int y);
+void SpawnTrail(ParticleSystem* system, int x, int y, uint32_t color);
+
+#endif
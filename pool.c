@@ -0,0 +1,32 @@
+#include "pool.h"
+
+#include <string.h>
+
+// Empty the pool and reset its counters
+void InitPool(Pool* pool, int capacity) {
+    pool->capacity = capacity;
+    pool->count = 0;
+    pool->highWater = 0;
+    pool->exhausted = 0;
+}
+
+// First free slot, or -1 when the pool is full
+int AcquireSlot(Pool* pool) {
+    if (pool->count >= pool->capacity) {
+        pool->exhausted++;
+        return -1;
+    }
+    int slot = pool->count++;
+    if (pool->count > pool->highWater) {
+        pool->highWater = pool->count;
+    }
+    return slot;
+}
+
+// Free a live slot by moving the last live entry into it
+void ReleaseSlot(Pool* pool, void* items, size_t itemSize, int slot) {
+    int last = --pool->count;
+    if (slot != last) {
+        memcpy((char*)items + slot * itemSize, (char*)items + last * itemSize, itemSize);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Slot bookkeeping for a fixed array of entities owned by the caller. Live
+// entries stay packed at the front of the array, so walking them costs the
+// live count and never the capacity, and the free slots are simply the
+// tail: acquiring hands out the first free slot and releasing moves the
+// last live entry into the hole, both in constant time. A release reorders
+// entries, so no slot index may be kept across one.
+typedef struct {
+    int capacity;       // usable slots, at most the length of the array
+    int count;          // live entries, in slots [0, count)
+    int highWater;      // largest count since InitPool
+    uint32_t exhausted; // acquires refused because every slot was live
+} Pool;
+
+void InitPool(Pool* pool, int capacity);
+int AcquireSlot(Pool* pool);
+void ReleaseSlot(Pool* pool, void* items, size_t itemSize, int slot);
+
+#endif
@@ -0,0 +1,132 @@
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Marks timed to measure what one costs
+#define CALIBRATION_MARKS 4096
+
+// Simulation phases and drawing both have aliens, bullets and so on
+static const char* zoneNames[PROFILE_ZONE_COUNT] = {
+    "tick_input", "tick_aliens", "tick_bullets", "tick_explosions", "tick_collisions",
+    "tick_cleanup", "tick_particles",
+    "draw_setup", "draw_stars", "draw_nebulae", "draw_shields", "draw_player",
+    "draw_aliens", "draw_bullets", "draw_explosions", "draw_particles", "draw_commands", "draw_text", "draw_overlay",
+    "present"
+};
+
+static uint32_t ClampNs(int64_t ns) {
+    if (ns < 0) return 0;
+    if (ns > (int64_t)UINT32_MAX) return UINT32_MAX;
+    return (uint32_t)ns;
+}
+
+// Time a burst of marks into a throwaway frame to learn the cost of one,
+// which is what EndProfileFrame charges per mark as overhead
+void InitProfiler(Profiler* profiler, int64_t (*now)(void)) {
+    memset(profiler, 0, sizeof(Profiler));
+    profiler->now = now;
+    profiler->zone = PROFILE_NONE;
+
+    int64_t start = now();
+    for (int i = 0; i < CALIBRATION_MARKS; i++) {
+        ProfileMark(profiler, i & 1 ? PROFILE_NONE : PROFILE_RENDER_SETUP);
+    }
+    profiler->markCost = (double)(now() - start) / CALIBRATION_MARKS;
+
+    profiler->zone = PROFILE_NONE;
+    profiler->marks = 0;
+    memset(profiler->current, 0, sizeof(profiler->current));
+}
+
+void BeginProfileFrame(Profiler* profiler) {
+    profiler->frameStart = profiler->now();
+    profiler->zone = PROFILE_NONE;
+    profiler->marks = 0;
+    memset(profiler->current, 0, sizeof(profiler->current));
+}
+
+// Close the running zone and record the frame into the ring
+void EndProfileFrame(Profiler* profiler) {
+    ProfileMark(profiler, PROFILE_NONE);
+    uint32_t* row = profiler->history[profiler->frames % PROFILER_HISTORY];
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+        row[zone] = ClampNs(profiler->current[zone]);
+    }
+    row[PROFILE_COLUMN_FRAME] = ClampNs(profiler->zoneStart - profiler->frameStart);
+    row[PROFILE_COLUMN_OVERHEAD] = ClampNs((int64_t)(profiler->marks * profiler->markCost));
+    profiler->frames++;
+}
+
+// GamePhaseMarker for Game.phaseMarker, with the profiler as context
+void ProfilePhaseMarker(void* context, GamePhase phase) {
+    ProfileMark(context, phase == GAME_PHASE_COUNT ? PROFILE_NONE : (int)phase);
+}
+
+const char* ProfileColumnName(int column) {
+    if (column >= 0 && column < PROFILE_ZONE_COUNT) return zoneNames[column];
+    if (column == PROFILE_COLUMN_FRAME) return "frame";
+    if (column == PROFILE_COLUMN_OVERHEAD) return "profiler";
+    return "unknown";
+}
+
+int RecordedProfileFrames(const Profiler* profiler) {
+    return profiler->frames < PROFILER_HISTORY ? (int)profiler->frames : PROFILER_HISTORY;
+}
+
+static int CompareValues(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Min, average and 99th percentile of every column over the frames in the
+// ring, recomputed once every PROFILER_STATS_INTERVAL frames
+const ProfileStats* UpdateProfileStats(Profiler* profiler) {
+    if (profiler->frames == profiler->statsFrame ||
+        (profiler->statsFrame != 0 && profiler->frames - profiler->statsFrame < PROFILER_STATS_INTERVAL)) {
+        return profiler->stats;
+    }
+    profiler->statsFrame = profiler->frames;
+
+    int count = RecordedProfileFrames(profiler);
+    for (int column = 0; column < PROFILE_COLUMN_COUNT; column++) {
+        uint64_t sum = 0;
+        for (int i = 0; i < count; i++) {
+            profiler->scratch[i] = profiler->history[i][column];
+            sum += profiler->scratch[i];
+        }
+        qsort(profiler->scratch, (size_t)count, sizeof(uint32_t), CompareValues);
+        ProfileStats* stats = &profiler->stats[column];
+        stats->min = profiler->scratch[0];
+        stats->avg = (uint32_t)(sum / (uint64_t)count);
+        stats->p99 = profiler->scratch[(count - 1) * 99 / 100];
+    }
+    return profiler->stats;
+}
+
+// One line per recorded frame, oldest first, times in microseconds
+bool WriteProfileCsv(const Profiler* profiler, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+    fprintf(file, "frame");
+    for (int column = 0; column < PROFILE_COLUMN_COUNT; column++) {
+        fprintf(file, ",%s_us", ProfileColumnName(column));
+    }
+    fprintf(file, "\n");
+
+    int count = RecordedProfileFrames(profiler);
+    long first = profiler->frames - count;
+    for (long frame = first; frame < profiler->frames; frame++) {
+        const uint32_t* row = profiler->history[frame % PROFILER_HISTORY];
+        fprintf(file, "%ld", frame);
+        for (int column = 0; column < PROFILE_COLUMN_COUNT; column++) {
+            fprintf(file, ",%.3f", row[column] / 1000.0);
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
@@ -0,0 +1,87 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// Frames kept for statistics and the CSV dump
+#define PROFILER_HISTORY 1024
+
+// Statistics are refreshed this often, in frames
+#define PROFILER_STATS_INTERVAL 30
+
+// Where a frame goes: the simulation phases first (same numbers as
+// GamePhase), then the parts of rendering
+typedef enum {
+    PROFILE_RENDER_SETUP = GAME_PHASE_COUNT, // back buffer and cached layers
+    PROFILE_RENDER_STARS,                    // clear and stars, or the whole GDI layer
+    PROFILE_RENDER_NEBULAE,                  // software only, GDI has them baked
+    PROFILE_RENDER_SHIELDS,
+    PROFILE_RENDER_PLAYER,
+    PROFILE_RENDER_ALIENS,
+    PROFILE_RENDER_BULLETS,
+    PROFILE_RENDER_EXPLOSIONS,
+    PROFILE_RENDER_PARTICLES,
+    PROFILE_RENDER_COMMANDS,                 // batched drawing calls replayed
+    PROFILE_RENDER_TEXT,                     // HUD and menu screens
+    PROFILE_RENDER_OVERLAY,
+    PROFILE_RENDER_PRESENT,                  // back buffer to the window
+    PROFILE_ZONE_COUNT,
+    PROFILE_NONE = PROFILE_ZONE_COUNT        // time nobody asked about
+} ProfileZone;
+
+// Columns of a recorded frame: every zone, the whole frame and the
+// profiler's own estimated cost
+enum {
+    PROFILE_COLUMN_FRAME = PROFILE_ZONE_COUNT,
+    PROFILE_COLUMN_OVERHEAD,
+    PROFILE_COLUMN_COUNT
+};
+
+typedef struct {
+    uint32_t min, avg, p99; // nanoseconds
+} ProfileStats;
+
+// Marker-style profiler: ProfileMark closes the running zone and opens the
+// next one, so a frame is one clock read per mark. Finished frames go into
+// a ring of PROFILER_HISTORY entries; nothing is allocated after init.
+typedef struct {
+    int64_t (*now)(void);     // nanoseconds
+    int64_t frameStart;
+    int64_t zoneStart;
+    int zone;                 // running zone, PROFILE_NONE between zones
+    int marks;                // clock reads this frame
+    int64_t current[PROFILE_ZONE_COUNT];
+    double markCost;          // ns per mark, measured by InitProfiler
+
+    uint32_t history[PROFILER_HISTORY][PROFILE_COLUMN_COUNT];
+    long frames;              // recorded since init, the ring holds the last ones
+
+    ProfileStats stats[PROFILE_COLUMN_COUNT];
+    long statsFrame;          // frames when stats were last computed
+    uint32_t scratch[PROFILER_HISTORY];
+} Profiler;
+
+void InitProfiler(Profiler* profiler, int64_t (*now)(void));
+void BeginProfileFrame(Profiler* profiler);
+void EndProfileFrame(Profiler* profiler);
+void ProfilePhaseMarker(void* context, GamePhase phase);
+const char* ProfileColumnName(int column);
+int RecordedProfileFrames(const Profiler* profiler);
+const ProfileStats* UpdateProfileStats(Profiler* profiler);
+bool WriteProfileCsv(const Profiler* profiler, const char* path);
+
+// Close the running zone and start another (PROFILE_NONE to stop timing)
+static inline void ProfileMark(Profiler* profiler, int zone) {
+    int64_t now = profiler->now();
+    if (profiler->zone != PROFILE_NONE) {
+        profiler->current[profiler->zone] += now - profiler->zoneStart;
+    }
+    profiler->zone = zone;
+    profiler->zoneStart = now;
+    profiler->marks++;
+}
+
+#endif
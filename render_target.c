@@ -0,0 +1,80 @@
+#include "render_target.h"
+
+#include <stddef.h>
+
+// Memory backend
+static bool CreateMemorySurface(RenderTarget* target, int width, int height) {
+    if (!CreateFramebuffer(&target->framebuffer, width, height)) {
+        return false;
+    }
+    CountRenderAllocation(target);
+    target->surface = &target->framebuffer;
+    return true;
+}
+
+static void DestroyMemorySurface(RenderTarget* target) {
+    DestroyFramebuffer(&target->framebuffer);
+    target->surface = NULL;
+}
+
+const RenderTargetBackend memoryRenderTarget = {
+    CreateMemorySurface,
+    DestroyMemorySurface
+};
+
+// Initialize an empty target, the surface is created by the first frame
+void InitRenderTarget(RenderTarget* target, const RenderTargetBackend* backend, void* device) {
+    target->backend = backend;
+    target->device = device;
+    target->surface = NULL;
+    target->bitmap = NULL;
+    target->previous = NULL;
+    target->framebuffer.pixels = NULL;
+    target->framebuffer.width = 0;
+    target->framebuffer.height = 0;
+    target->framebuffer.stride = 0;
+    target->width = 0;
+    target->height = 0;
+    target->valid = false;
+    target->frames = 0;
+    target->allocations = 0;
+    target->frameAllocations = 0;
+}
+
+// Start a frame, rebuilding the surface only if the size changed
+bool BeginRenderFrame(RenderTarget* target, int width, int height) {
+    target->frames++;
+    target->frameAllocations = 0;
+
+    if (target->valid && target->width == width && target->height == height) {
+        return true;
+    }
+
+    if (target->valid) {
+        target->backend->destroy(target);
+        target->valid = false;
+    }
+
+    if (width <= 0 || height <= 0 || !target->backend->create(target, width, height)) {
+        return false;
+    }
+
+    target->width = width;
+    target->height = height;
+    target->valid = true;
+    return true;
+}
+
+// Free the surface
+void ReleaseRenderTarget(RenderTarget* target) {
+    if (target->valid) {
+        target->backend->destroy(target);
+        target->valid = false;
+    }
+}
+
+// Called by backends for each resource they allocate
+void CountRenderAllocation(RenderTarget* target) {
+    target->allocations++;
+    target->frameAllocations++;
+}
@@ -0,0 +1,44 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <stdbool.h>
+
+#include "framebuffer.h"
+
+typedef struct RenderTarget RenderTarget;
+
+// Backend hooks: create the surface for a size, destroy it again
+typedef struct {
+    bool (*create)(RenderTarget* target, int width, int height);
+    void (*destroy)(RenderTarget* target);
+} RenderTargetBackend;
+
+// Back buffer that lives from frame to frame and is only rebuilt when the
+// requested size changes. Backends report every resource they create through
+// CountRenderAllocation, so a steady-state frame can be checked for zero.
+struct RenderTarget {
+    const RenderTargetBackend* backend;
+    void* device;   // what surfaces are made compatible with (screen HDC for GDI)
+    void* surface;  // drawing handle (memory HDC for GDI)
+    void* bitmap;   // storage (HBITMAP for GDI)
+    void* previous; // object displaced when the storage was selected
+    Framebuffer framebuffer; // pixels of the memory backend
+
+    int width, height;
+    bool valid;
+
+    // Counters
+    long frames;
+    long allocations;
+    long frameAllocations;
+};
+
+// Backend that renders into a Framebuffer, available on every platform
+extern const RenderTargetBackend memoryRenderTarget;
+
+void InitRenderTarget(RenderTarget* target, const RenderTargetBackend* backend, void* device);
+bool BeginRenderFrame(RenderTarget* target, int width, int height);
+void ReleaseRenderTarget(RenderTarget* target);
+void CountRenderAllocation(RenderTarget* target);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// PCG32 (XSH RR): 64-bit state, 32-bit output. Small, fast, and every
+// instance is its own independent stream.
+typedef struct {
+    uint64_t state;
+    uint64_t increment; // stream selector, always odd
+} Rng;
+
+static inline uint32_t RandomNext(Rng* rng) {
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->increment;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rotation = (uint32_t)(old >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+}
+
+static inline void SeedRandom(Rng* rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->increment = (stream << 1) | 1;
+    RandomNext(rng);
+    rng->state += seed;
+    RandomNext(rng);
+}
+
+// Uniform value in [0, bound) using a multiply instead of a division
+static inline int RandomRange(Rng* rng, int bound) {
+    return (int)(((uint64_t)RandomNext(rng) * (uint32_t)bound) >> 32);
+}
+
+#endif
@@ -0,0 +1,476 @@
+#include "savestate.h"
+#include "varint.h"
+
+#include <limits.h>
+#include <string.h>
+
+// Longest varint of an int, of a zigzag int or of the delta of two ints
+#define INT_VARINT_SIZE 5
+#define U64_VARINT_SIZE 10
+
+// Output cursor. SaveGameState checks the worst case up front, so nothing
+// here checks for room. Bits are packed low first and every bitset ends on
+// a byte boundary.
+typedef struct {
+    uint8_t* out;
+    size_t size;
+    uint32_t bits;
+    int bitCount;
+} Writer;
+
+// Input cursor; ok turns false at the first read past the end or bad value
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+    uint32_t bits;
+    int bitCount;
+    bool ok;
+} Reader;
+
+// FNV-1a over the bytes of each configuration field, named one by one so
+// a new field has to be added here to count. The particle count is left
+// out: particles are not saved, so a windowed game's save loads in a
+// headless one
+static uint32_t HashField(uint32_t hash, int value) {
+    for (int i = 0; i < 4; i++) {
+        hash = (hash ^ (((uint32_t)value >> (i * 8)) & 0xFF)) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t HashConfig(const GameConfig* config) {
+    uint32_t hash = 2166136261u;
+    hash = HashField(hash, config->worldWidth);
+    hash = HashField(hash, config->worldHeight);
+    hash = HashField(hash, config->alienRows);
+    hash = HashField(hash, config->alienCols);
+    hash = HashField(hash, config->shieldCount);
+    hash = HashField(hash, config->playerBullets);
+    hash = HashField(hash, config->alienBullets);
+    hash = HashField(hash, config->explosions);
+    hash = HashField(hash, config->playerSpeed);
+    hash = HashField(hash, config->playerBulletSpeed);
+    hash = HashField(hash, config->alienBulletSpeed);
+    hash = HashField(hash, config->alienMoveSpeed);
+    hash = HashField(hash, config->alienShootDelay);
+    hash = HashField(hash, config->alienVolley);
+    hash = HashField(hash, config->levels);
+    hash = HashField(hash, config->moveDelayStart);
+    hash = HashField(hash, config->moveDelayStep);
+    hash = HashField(hash, config->moveDelayMin);
+    hash = HashField(hash, config->shootDelayStart);
+    hash = HashField(hash, config->shootDelayStep);
+    hash = HashField(hash, config->shootDelayMin);
+    return hash;
+}
+
+static void PutVarint(Writer* writer, uint64_t value) {
+    writer->size += WriteVarint(writer->out + writer->size, value);
+}
+
+static void PutInt(Writer* writer, int64_t value) {
+    PutVarint(writer, ZigzagEncode(value));
+}
+
+// Raw little-endian bytes, for values that are random and would not shrink
+static void PutFixed(Writer* writer, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        writer->out[writer->size++] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+// At most 16 bits at a time
+static void PutBits(Writer* writer, uint32_t value, int count) {
+    writer->bits |= value << writer->bitCount;
+    writer->bitCount += count;
+    while (writer->bitCount >= 8) {
+        writer->out[writer->size++] = (uint8_t)writer->bits;
+        writer->bits >>= 8;
+        writer->bitCount -= 8;
+    }
+}
+
+static void EndBits(Writer* writer) {
+    if (writer->bitCount > 0) {
+        writer->out[writer->size++] = (uint8_t)writer->bits;
+    }
+    writer->bits = 0;
+    writer->bitCount = 0;
+}
+
+static uint64_t GetVarint(Reader* reader) {
+    uint64_t value;
+    if (!ReadVarint(reader->data, reader->size, &reader->offset, &value)) {
+        reader->ok = false;
+        return 0;
+    }
+    return value;
+}
+
+static int GetInt(Reader* reader) {
+    return (int)ZigzagDecode(GetVarint(reader));
+}
+
+// A signed value that the simulation only ever leaves in [min, max]
+static int GetIntIn(Reader* reader, int min, int max) {
+    int64_t value = ZigzagDecode(GetVarint(reader));
+    if (value < min || value > max) {
+        reader->ok = false;
+        return min;
+    }
+    return (int)value;
+}
+
+// A count or an enum value in [0, max]
+static int GetCount(Reader* reader, int max) {
+    uint64_t value = GetVarint(reader);
+    if (value > (uint64_t)max) {
+        reader->ok = false;
+        return 0;
+    }
+    return (int)value;
+}
+
+// A counter the simulation keeps in 32 bits
+static uint32_t GetUint32(Reader* reader) {
+    uint64_t value = GetVarint(reader);
+    if (value > UINT32_MAX) {
+        reader->ok = false;
+        return 0;
+    }
+    return (uint32_t)value;
+}
+
+static uint64_t GetFixed(Reader* reader, int bytes) {
+    if (reader->size - reader->offset < (size_t)bytes) {
+        reader->ok = false;
+        return 0;
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)reader->data[reader->offset++] << (i * 8);
+    }
+    return value;
+}
+
+static uint32_t GetBits(Reader* reader, int count) {
+    while (reader->bitCount < count) {
+        if (reader->offset >= reader->size) {
+            reader->ok = false;
+            return 0;
+        }
+        reader->bits |= (uint32_t)reader->data[reader->offset++] << reader->bitCount;
+        reader->bitCount += 8;
+    }
+    uint32_t value = reader->bits & ((1u << count) - 1);
+    reader->bits >>= count;
+    reader->bitCount -= count;
+    return value;
+}
+
+static void SkipToByte(Reader* reader) {
+    reader->bits = 0;
+    reader->bitCount = 0;
+}
+
+static void PutPool(Writer* writer, const Pool* pool) {
+    PutVarint(writer, (uint64_t)pool->count);
+    PutVarint(writer, (uint64_t)pool->highWater);
+    PutVarint(writer, pool->exhausted);
+}
+
+static void GetPool(Reader* reader, Pool* pool) {
+    pool->count = GetCount(reader, pool->capacity);
+    pool->highWater = GetCount(reader, pool->capacity);
+    if (pool->highWater < pool->count) {
+        reader->ok = false;
+    }
+    pool->exhausted = GetUint32(reader);
+}
+
+// Positions, then the previous positions as deltas (a tick of movement)
+static void PutBullets(Writer* writer, const Bullet* bullets, int count) {
+    for (int i = 0; i < count; i++) {
+        PutInt(writer, bullets[i].x);
+        PutInt(writer, bullets[i].y);
+        PutInt(writer, (int64_t)bullets[i].prevX - bullets[i].x);
+        PutInt(writer, (int64_t)bullets[i].prevY - bullets[i].y);
+    }
+    for (int i = 0; i < count; i++) {
+        PutBits(writer, bullets[i].active, 1);
+    }
+    EndBits(writer);
+}
+
+// With no bullets to fill, the entries are only read and checked
+static void GetBullets(Reader* reader, Bullet* bullets, int count) {
+    Bullet discard;
+    for (int i = 0; i < count; i++) {
+        Bullet* bullet = bullets != NULL ? &bullets[i] : &discard;
+        bullet->x = GetInt(reader);
+        bullet->y = GetInt(reader);
+        bullet->prevX = (int)((int64_t)bullet->x + GetInt(reader));
+        bullet->prevY = (int)((int64_t)bullet->y + GetInt(reader));
+    }
+    for (int i = 0; i < count; i++) {
+        bool active = GetBits(reader, 1);
+        if (bullets != NULL) {
+            bullets[i].active = active;
+        }
+    }
+    SkipToByte(reader);
+}
+
+static void PutExplosions(Writer* writer, const Explosion* explosions, int count) {
+    for (int i = 0; i < count; i++) {
+        PutInt(writer, explosions[i].x);
+        PutInt(writer, explosions[i].y);
+        PutInt(writer, explosions[i].frame);
+        PutInt(writer, explosions[i].timer);
+    }
+    for (int i = 0; i < count; i++) {
+        PutBits(writer, explosions[i].active, 1);
+    }
+    EndBits(writer);
+}
+
+static void GetExplosions(Reader* reader, Explosion* explosions, int count) {
+    Explosion discard;
+    for (int i = 0; i < count; i++) {
+        Explosion* explosion = explosions != NULL ? &explosions[i] : &discard;
+        explosion->x = GetInt(reader);
+        explosion->y = GetInt(reader);
+        explosion->frame = GetIntIn(reader, 0, EXPLOSION_FRAMES - 1);
+        explosion->timer = GetIntIn(reader, 0, EXPLOSION_DURATION - 1);
+    }
+    for (int i = 0; i < count; i++) {
+        bool active = GetBits(reader, 1);
+        if (explosions != NULL) {
+            explosions[i].active = active;
+        }
+    }
+    SkipToByte(reader);
+}
+
+// The pools and their live entries, the last part of a blob. The first
+// pass of a restore checks them into a scratch game without entries; the
+// second one, which cannot fail, fills the real pools.
+static void GetEntries(Reader* reader, Game* game, bool fill) {
+    GetPool(reader, &game->playerBulletPool);
+    GetBullets(reader, fill ? game->playerBullets : NULL, game->playerBulletPool.count);
+    GetPool(reader, &game->alienBulletPool);
+    GetBullets(reader, fill ? game->alienBullets : NULL, game->alienBulletPool.count);
+    GetPool(reader, &game->explosionPool);
+    GetExplosions(reader, fill ? game->explosions : NULL, game->explosionPool.count);
+}
+
+// Largest blob SaveGameState can write for this game: every varint at its
+// longest and every pool full
+size_t SaveStateCapacity(const Game* game) {
+    const Formation* formation = &game->formation;
+    int shields = game->config.shieldCount;
+    size_t size = SAVE_STATE_HEADER_SIZE;
+    size += 6 * INT_VARINT_SIZE + U64_VARINT_SIZE + 16 + 1 + MAX_PENDING_INPUTS;
+    size += 4 * INT_VARINT_SIZE;
+    size += 6 * INT_VARINT_SIZE;
+    size += 9 * INT_VARINT_SIZE + (size_t)formation->cols * VarintSize(FORMATION_MAX_COLS - 1);
+    size += ((size_t)formation->rows * formation->cols + 7) / 8;
+    size += (size_t)shields * 2 * INT_VARINT_SIZE + ((size_t)shields * SHIELD_ROWS * SHIELD_COLS + 7) / 8;
+
+    const Pool* pools[] = {&game->playerBulletPool, &game->alienBulletPool, &game->explosionPool};
+    for (int p = 0; p < 3; p++) {
+        size_t capacity = (size_t)pools[p]->capacity;
+        size += 3 * INT_VARINT_SIZE + capacity * 4 * INT_VARINT_SIZE + (capacity + 7) / 8;
+    }
+    return size;
+}
+
+// Serialize the gameplay state, returns the number of bytes written or 0
+// if SaveStateCapacity bytes don't fit
+size_t SaveGameState(const Game* game, uint8_t* buffer, size_t capacity) {
+    if (capacity < SaveStateCapacity(game)) {
+        return 0;
+    }
+
+    Writer writer = {buffer, 0, 0, 0};
+    memcpy(buffer, SAVE_STATE_MAGIC, 4);
+    writer.size = 4;
+    buffer[writer.size++] = SAVE_STATE_VERSION;
+    PutFixed(&writer, HashConfig(&game->config), 4);
+
+    // Progress and the random stream
+    PutVarint(&writer, (uint64_t)game->state);
+    PutVarint(&writer, game->tick);
+    PutInt(&writer, game->score);
+    PutInt(&writer, game->level);
+    PutInt(&writer, game->gameOverTimer);
+    PutInt(&writer, game->stepTicks);
+    PutVarint(&writer, game->seed);
+    PutFixed(&writer, game->rng.state, 8);
+    PutFixed(&writer, game->rng.increment, 8);
+    PutVarint(&writer, (uint64_t)game->pendingInputCount);
+    for (int i = 0; i < game->pendingInputCount; i++) {
+        PutVarint(&writer, (uint64_t)game->pendingInputs[i]);
+    }
+
+    // Player
+    PutInt(&writer, game->playerX);
+    PutInt(&writer, game->playerY);
+    PutInt(&writer, (int64_t)game->prevPlayerX - game->playerX);
+    PutInt(&writer, game->playerLives);
+
+    // Aliens: timers, geometry, the live column order and one bit per cell
+    const Formation* formation = &game->formation;
+    PutVarint(&writer, (uint64_t)game->alienDirection);
+    PutInt(&writer, game->alienMoveTimer);
+    PutInt(&writer, game->alienMoveDelay);
+    PutInt(&writer, game->alienDropDistance);
+    PutInt(&writer, game->alienShootTimer);
+    PutInt(&writer, game->alienShootDelay);
+    PutVarint(&writer, (uint64_t)formation->rows);
+    PutVarint(&writer, (uint64_t)formation->cols);
+    PutInt(&writer, formation->originX);
+    PutInt(&writer, formation->originY);
+    PutInt(&writer, formation->pitchX);
+    PutInt(&writer, formation->pitchY);
+    PutInt(&writer, formation->width);
+    PutInt(&writer, formation->height);
+    PutVarint(&writer, (uint64_t)formation->liveColumnCount);
+    for (int i = 0; i < formation->liveColumnCount; i++) {
+        PutVarint(&writer, (uint64_t)formation->liveColumns[i]);
+    }
+    for (int row = 0; row < formation->rows; row++) {
+        for (int col = 0; col < formation->cols; col += 16) {
+            int count = formation->cols - col < 16 ? formation->cols - col : 16;
+            uint32_t bits = (uint32_t)(formation->alive[row][col >> 6] >> (col & 63));
+            PutBits(&writer, bits & ((1u << count) - 1), count);
+        }
+    }
+    EndBits(&writer);
+
+    // Shields: positions, then every block bit
+    for (int s = 0; s < game->config.shieldCount; s++) {
+        PutInt(&writer, game->shields[s].x);
+        PutInt(&writer, game->shields[s].y);
+    }
+    for (int s = 0; s < game->config.shieldCount; s++) {
+        for (int y = 0; y < SHIELD_ROWS; y++) {
+            PutBits(&writer, game->shields[s].rows[y], SHIELD_COLS);
+        }
+    }
+    EndBits(&writer);
+
+    // Live pool entries
+    PutPool(&writer, &game->playerBulletPool);
+    PutBullets(&writer, game->playerBullets, game->playerBulletPool.count);
+    PutPool(&writer, &game->alienBulletPool);
+    PutBullets(&writer, game->alienBullets, game->alienBulletPool.count);
+    PutPool(&writer, &game->explosionPool);
+    PutExplosions(&writer, game->explosions, game->explosionPool.count);
+    return writer.size;
+}
+
+// Load a save state into a game created with the same configuration, in
+// place and without allocating. The blob is decoded into a scratch copy of
+// the game on the stack and every value checked against what the
+// simulation can produce (delays and step of at least one tick, frames
+// within the animation...), so a foreign, damaged or hostile blob is
+// refused with the game untouched.
+bool RestoreGameState(Game* game, const uint8_t* data, size_t size) {
+    if (size < SAVE_STATE_HEADER_SIZE || memcmp(data, SAVE_STATE_MAGIC, 4) != 0 ||
+        data[4] != SAVE_STATE_VERSION) {
+        return false;
+    }
+    Reader reader = {data, size, 5, 0, 0, true};
+    if (GetFixed(&reader, 4) != HashConfig(&game->config)) {
+        return false;
+    }
+
+    // Configuration, pool capacities and everything else not in the blob
+    // come from the game itself
+    Game scratch;
+    memcpy(&scratch, game, offsetof(Game, playerBullets));
+    const GameConfig* config = &game->config;
+
+    scratch.state = (GameState)GetCount(&reader, GAME_WIN);
+    scratch.tick = GetUint32(&reader);
+    scratch.score = GetIntIn(&reader, 0, INT_MAX);
+    scratch.level = GetIntIn(&reader, 1, config->levels + 1);
+    scratch.gameOverTimer = GetIntIn(&reader, 0, INT_MAX);
+    scratch.stepTicks = GetIntIn(&reader, 1, INT_MAX);
+    scratch.seed = GetVarint(&reader);
+    scratch.rng.state = GetFixed(&reader, 8);
+    scratch.rng.increment = GetFixed(&reader, 8);
+    if ((scratch.rng.increment & 1) == 0) {
+        reader.ok = false; // PCG32 needs an odd increment
+    }
+    scratch.pendingInputCount = GetCount(&reader, MAX_PENDING_INPUTS);
+    for (int i = 0; i < scratch.pendingInputCount; i++) {
+        scratch.pendingInputs[i] = (GameInput)GetCount(&reader, INPUT_COUNT - 1);
+    }
+
+    scratch.playerX = GetInt(&reader);
+    scratch.playerY = GetInt(&reader);
+    scratch.prevPlayerX = (int)((int64_t)scratch.playerX + GetInt(&reader));
+    scratch.playerLives = GetIntIn(&reader, -config->alienBullets, INT_MAX); // every bullet of a tick can hit
+
+    // The formation is always the configured size
+    Formation* formation = &scratch.formation;
+    int16_t liveColumns[FORMATION_MAX_COLS];
+    scratch.alienDirection = (Direction)GetCount(&reader, DIR_RIGHT);
+    scratch.alienMoveTimer = GetIntIn(&reader, 0, INT_MAX);
+    scratch.alienMoveDelay = GetIntIn(&reader, 1, INT_MAX);
+    scratch.alienDropDistance = GetIntIn(&reader, 0, INT_MAX);
+    scratch.alienShootTimer = GetIntIn(&reader, 0, INT_MAX);
+    scratch.alienShootDelay = GetIntIn(&reader, 1, INT_MAX);
+    formation->rows = GetCount(&reader, FORMATION_MAX_ROWS);
+    formation->cols = GetCount(&reader, FORMATION_MAX_COLS);
+    if (formation->rows != config->alienRows || formation->cols != config->alienCols) {
+        return false;
+    }
+    formation->originX = GetInt(&reader);
+    formation->originY = GetInt(&reader);
+    formation->pitchX = GetIntIn(&reader, 1, INT_MAX);
+    formation->pitchY = GetIntIn(&reader, 1, INT_MAX);
+    formation->width = GetIntIn(&reader, 1, INT_MAX);
+    formation->height = GetIntIn(&reader, 1, INT_MAX);
+    int liveColumnCount = GetCount(&reader, formation->cols);
+    for (int i = 0; i < liveColumnCount; i++) {
+        liveColumns[i] = (int16_t)GetCount(&reader, FORMATION_MAX_COLS - 1);
+    }
+    memset(formation->alive, 0, sizeof(formation->alive));
+    for (int row = 0; row < formation->rows; row++) {
+        for (int col = 0; col < formation->cols; col += 16) {
+            int count = formation->cols - col < 16 ? formation->cols - col : 16;
+            formation->alive[row][col >> 6] |= (uint64_t)GetBits(&reader, count) << (col & 63);
+        }
+    }
+    SkipToByte(&reader);
+    if (!reader.ok || !RestoreFormation(formation, liveColumns, liveColumnCount)) {
+        return false;
+    }
+
+    for (int s = 0; s < config->shieldCount; s++) {
+        scratch.shields[s].x = GetInt(&reader);
+        scratch.shields[s].y = GetInt(&reader);
+    }
+    for (int s = 0; s < config->shieldCount; s++) {
+        for (int y = 0; y < SHIELD_ROWS; y++) {
+            scratch.shields[s].rows[y] = (uint16_t)GetBits(&reader, SHIELD_COLS);
+        }
+    }
+    SkipToByte(&reader);
+
+    size_t entries = reader.offset;
+    GetEntries(&reader, &scratch, false);
+    if (!reader.ok || reader.offset != size) {
+        return false;
+    }
+
+    // Everything checked: commit
+    memcpy(game, &scratch, offsetof(Game, playerBullets));
+    Reader fill = {data, size, entries, 0, 0, true};
+    GetEntries(&fill, game, true);
+    return true;
+}
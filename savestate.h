@@ -0,0 +1,24 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// Save state: the gameplay part of a Game in a few hundred bytes. "SISS",
+// version byte, 32-bit hash of the gameplay GameConfig, then varints (zigzag for
+// signed values, previous positions as deltas) and byte-aligned bitsets for
+// the alien, shield block and entity active flags. What the configuration
+// or the alive flags determine (pool capacities, row types, per-column
+// bookkeeping) is rebuilt on restore; particles are cosmetic and not saved.
+#define SAVE_STATE_MAGIC "SISS"
+#define SAVE_STATE_VERSION 1
+#define SAVE_STATE_HEADER_SIZE 9
+
+size_t SaveStateCapacity(const Game* game);
+size_t SaveGameState(const Game* game, uint8_t* buffer, size_t capacity);
+bool RestoreGameState(Game* game, const uint8_t* data, size_t size);
+
+#endif
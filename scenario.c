@@ -0,0 +1,176 @@
+#include "scenario.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Configuration keys and the range each accepts
+typedef struct {
+    const char* key;
+    size_t offset;
+    long min, max;
+} ConfigKey;
+
+static const ConfigKey configKeys[] = {
+    {"world_width", offsetof(GameConfig, worldWidth), 320, 65536},
+    {"world_height", offsetof(GameConfig, worldHeight), 320, 65536},
+    {"alien_rows", offsetof(GameConfig, alienRows), 1, FORMATION_MAX_ROWS},
+    {"alien_cols", offsetof(GameConfig, alienCols), 1, FORMATION_MAX_COLS},
+    {"shields", offsetof(GameConfig, shieldCount), 0, MAX_SHIELDS},
+    {"player_bullets", offsetof(GameConfig, playerBullets), 1, 1000000},
+    {"alien_bullets", offsetof(GameConfig, alienBullets), 1, 1000000},
+    {"explosions", offsetof(GameConfig, explosions), 1, 1000000},
+    {"player_speed", offsetof(GameConfig, playerSpeed), 1, 1000},
+    {"player_bullet_speed", offsetof(GameConfig, playerBulletSpeed), 1, 1000},
+    {"alien_bullet_speed", offsetof(GameConfig, alienBulletSpeed), 1, 1000},
+    {"alien_move_speed", offsetof(GameConfig, alienMoveSpeed), 1, 1000},
+    {"alien_shoot_delay", offsetof(GameConfig, alienShootDelay), 0, 100000},
+    {"alien_volley", offsetof(GameConfig, alienVolley), 1, 100000},
+    {"particles", offsetof(GameConfig, particles), 0, 10000000},
+    {"levels", offsetof(GameConfig, levels), 1, MAX_LEVELS},
+    {"move_delay_start", offsetof(GameConfig, moveDelayStart), 1, 100000},
+    {"move_delay_step", offsetof(GameConfig, moveDelayStep), 0, 100000},
+    {"move_delay_min", offsetof(GameConfig, moveDelayMin), 1, 100000},
+    {"shoot_delay_start", offsetof(GameConfig, shootDelayStart), 1, 100000},
+    {"shoot_delay_step", offsetof(GameConfig, shootDelayStep), 0, 100000},
+    {"shoot_delay_min", offsetof(GameConfig, shootDelayMin), 1, 100000},
+};
+
+#define CONFIG_KEY_COUNT (int)(sizeof(configKeys) / sizeof(configKeys[0]))
+
+// The classic game, for ten minutes at 60 Hz
+void DefaultScenario(Scenario* scenario) {
+    snprintf(scenario->name, sizeof(scenario->name), "classic");
+    scenario->ticks = 36000;
+    scenario->seed = 1;
+    DefaultGameConfig(&scenario->config);
+}
+
+// Strip leading and trailing blanks in place
+static char* Trim(char* text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    size_t length = strlen(text);
+    while (length > 0 && isspace((unsigned char)text[length - 1])) {
+        text[--length] = '\0';
+    }
+    return text;
+}
+
+static bool ParseNumber(const char* text, long min, long max, long* value) {
+    char* end;
+    long number = strtol(text, &end, 0);
+    if (end == text || *end != '\0' || number < min || number > max) {
+        return false;
+    }
+    *value = number;
+    return true;
+}
+
+// Apply one "key = value" pair
+static bool ApplyScenarioKey(Scenario* scenario, const char* key, const char* value,
+                             char* error, size_t errorSize) {
+    long number;
+    if (strcmp(key, "name") == 0) {
+        snprintf(scenario->name, sizeof(scenario->name), "%s", value);
+        return true;
+    }
+    if (strcmp(key, "ticks") == 0) {
+        if (!ParseNumber(value, 1, 1000000000L, &number)) {
+            snprintf(error, errorSize, "ticks must be a positive number");
+            return false;
+        }
+        scenario->ticks = number;
+        return true;
+    }
+    if (strcmp(key, "seed") == 0) {
+        char* end;
+        scenario->seed = strtoull(value, &end, 0);
+        if (end == value || *end != '\0') {
+            snprintf(error, errorSize, "seed must be a number");
+            return false;
+        }
+        return true;
+    }
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        const ConfigKey* entry = &configKeys[i];
+        if (strcmp(key, entry->key) == 0) {
+            if (!ParseNumber(value, entry->min, entry->max, &number)) {
+                snprintf(error, errorSize, "%s must be between %ld and %ld", key, entry->min, entry->max);
+                return false;
+            }
+            *(int*)((char*)&scenario->config + entry->offset) = (int)number;
+            return true;
+        }
+    }
+    snprintf(error, errorSize, "unknown key %s", key);
+    return false;
+}
+
+// Read a scenario from text, on top of the classic defaults. On failure
+// the error names the offending line.
+bool ParseScenario(Scenario* scenario, const char* text, char* error, size_t errorSize) {
+    DefaultScenario(scenario);
+
+    int lineNumber = 0;
+    while (*text != '\0') {
+        char line[256];
+        size_t length = strcspn(text, "\n");
+        lineNumber++;
+        if (length >= sizeof(line)) {
+            snprintf(error, errorSize, "line %d: too long", lineNumber);
+            return false;
+        }
+        memcpy(line, text, length);
+        line[length] = '\0';
+        text += length + (text[length] == '\n');
+
+        char* comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        char* key = Trim(line);
+        if (*key == '\0') {
+            continue;
+        }
+        char* equals = strchr(key, '=');
+        if (equals == NULL) {
+            snprintf(error, errorSize, "line %d: expected key = value", lineNumber);
+            return false;
+        }
+        *equals = '\0';
+        char message[128];
+        if (!ApplyScenarioKey(scenario, Trim(key), Trim(equals + 1), message, sizeof(message))) {
+            snprintf(error, errorSize, "line %d: %s", lineNumber, message);
+            return false;
+        }
+    }
+
+    // The shields are laid out in one row across the world
+    if (scenario->config.shieldCount * SHIELD_WIDTH > scenario->config.worldWidth) {
+        snprintf(error, errorSize, "%d shields do not fit in a %d pixel wide world",
+                 scenario->config.shieldCount, scenario->config.worldWidth);
+        return false;
+    }
+    return true;
+}
+
+bool LoadScenario(Scenario* scenario, const char* path, char* error, size_t errorSize) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        snprintf(error, errorSize, "cannot open %s", path);
+        return false;
+    }
+    char text[8192];
+    size_t size = fread(text, 1, sizeof(text) - 1, file);
+    bool tooLong = !feof(file);
+    fclose(file);
+    if (tooLong) {
+        snprintf(error, errorSize, "%s is larger than %zu bytes", path, sizeof(text) - 1);
+        return false;
+    }
+    text[size] = '\0';
+    return ParseScenario(scenario, text, error, errorSize);
+}
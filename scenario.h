@@ -0,0 +1,31 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// Scenario file: plain "key = value" lines, # starts a comment. Keys left
+// out keep their classic value:
+//   name, ticks, seed, world_width, world_height, alien_rows, alien_cols,
+//   shields, player_bullets, alien_bullets, explosions, player_speed,
+//   player_bullet_speed, alien_bullet_speed, alien_move_speed,
+//   alien_shoot_delay, alien_volley, particles, levels, move_delay_start,
+//   move_delay_step, move_delay_min, shoot_delay_start, shoot_delay_step,
+//   shoot_delay_min
+#define SCENARIO_NAME_SIZE 64
+
+typedef struct {
+    char name[SCENARIO_NAME_SIZE];
+    long ticks;    // how long a benchmark runs it
+    uint64_t seed;
+    GameConfig config;
+} Scenario;
+
+void DefaultScenario(Scenario* scenario);
+bool ParseScenario(Scenario* scenario, const char* text, char* error, size_t errorSize);
+bool LoadScenario(Scenario* scenario, const char* path, char* error, size_t errorSize);
+
+#endif
@@ -0,0 +1,110 @@
+#include "scene.h"
+#include "loop.h"
+#include "particles.h"
+
+// One rectangle per active shield block, inset by a pixel on every side
+static void DrawShieldBlocks(Canvas* canvas, const Game* game, int inset, uint32_t color) {
+    for (int s = 0; s < game->config.shieldCount; s++) {
+        const Shield* shield = &game->shields[s];
+        for (int x = 0; x < SHIELD_COLS; x++) {
+            for (int y = 0; y < SHIELD_ROWS; y++) {
+                if (IsShieldBlockActive(shield, x, y)) {
+                    int blockX = shield->x + x * SHIELD_BLOCK_SIZE;
+                    int blockY = shield->y + y * SHIELD_BLOCK_SIZE;
+                    canvas->backend->fillRectangle(canvas, blockX + inset, blockY + inset,
+                                                   blockX + SHIELD_BLOCK_SIZE - inset,
+                                                   blockY + SHIELD_BLOCK_SIZE - inset, color);
+                }
+            }
+        }
+    }
+}
+
+// Shield blocks, green with the black outline of a GDI Rectangle. All the
+// outlines go first so that neither layer overlaps itself.
+void DrawShields(Canvas* canvas, const Game* game) {
+    BeginCanvasLayer(canvas, true);
+    DrawShieldBlocks(canvas, game, 0, FB_RGB(0, 0, 0));
+    BeginCanvasLayer(canvas, true);
+    DrawShieldBlocks(canvas, game, 1, FB_RGB(0, 255, 0));
+}
+
+// Player ship at its interpolated position
+void DrawPlayer(Canvas* canvas, const Game* game, double alpha) {
+    int playerX = InterpolateInt(game->prevPlayerX, game->playerX, alpha);
+    BeginCanvasLayer(canvas, false);
+    canvas->backend->drawSprite(canvas, SPRITE_PLAYER, playerX, game->playerY);
+}
+
+void DrawAliens(Canvas* canvas, const Game* game) {
+    const Formation* formation = &game->formation;
+    BeginCanvasLayer(canvas, true);
+    for (int row = 0; row < formation->rows; row++) {
+        SpriteId sprite = SPRITE_ALIEN_0 + formation->rowType[row];
+        int y = AlienY(formation, row);
+        for (int w = 0; w < FORMATION_ROW_WORDS; w++) {
+            for (uint64_t bits = formation->alive[row][w]; bits != 0; bits &= bits - 1) {
+                canvas->backend->drawSprite(canvas, sprite, AlienX(formation, w * 64 + LowestBit(bits)), y);
+            }
+        }
+    }
+}
+
+// Player bullets as white bars, alien bullets as red zigzags
+void DrawBullets(Canvas* canvas, const Game* game, double alpha) {
+    const CanvasBackend* backend = canvas->backend;
+    BeginCanvasLayer(canvas, true);
+    for (int i = 0; i < game->playerBulletPool.count; i++) {
+        int x = InterpolateInt(game->playerBullets[i].prevX, game->playerBullets[i].x, alpha);
+        int y = InterpolateInt(game->playerBullets[i].prevY, game->playerBullets[i].y, alpha);
+        backend->fillRectangle(canvas, x - 1, y, x + 2, y + 12, FB_RGB(255, 255, 255));
+    }
+
+    BeginCanvasLayer(canvas, true);
+    for (int i = 0; i < game->alienBulletPool.count; i++) {
+        int x = InterpolateInt(game->alienBullets[i].prevX, game->alienBullets[i].x, alpha);
+        int y = InterpolateInt(game->alienBullets[i].prevY, game->alienBullets[i].y, alpha);
+        int zigzag[] = {
+            x - 2, y,
+            x + 1, y + 3,
+            x - 2, y + 6,
+            x + 1, y + 9,
+            x - 2, y + 12,
+            x + 2, y + 12,
+            x - 1, y + 9,
+            x + 2, y + 6,
+            x - 1, y + 3,
+            x + 2, y
+        };
+        backend->fillPolygon(canvas, zigzag, 10, FB_RGB(255, 100, 100));
+    }
+}
+
+// Explosions grouped by frame, each group drawing one atlas cell. They can
+// overlap, so the order stays as drawn.
+void DrawExplosions(Canvas* canvas, const Game* game) {
+    BeginCanvasLayer(canvas, false);
+    for (int frame = 0; frame < EXPLOSION_FRAMES; frame++) {
+        for (int i = 0; i < game->explosionPool.count; i++) {
+            const Explosion* explosion = &game->explosions[i];
+            if (explosion->frame == frame) {
+                canvas->backend->drawSprite(canvas, SPRITE_EXPLOSION_0 + frame, explosion->x, explosion->y);
+            }
+        }
+    }
+}
+
+// Particles as 2x2 dots. Which of two overlapping dots ends up on top is
+// not worth a state change, so they may be grouped by color.
+void DrawParticles(Canvas* canvas, const Game* game) {
+    const ParticleSystem* particles = game->particles;
+    if (particles == NULL) {
+        return;
+    }
+    BeginCanvasLayer(canvas, true);
+    for (int i = 0; i < particles->pool.count; i++) {
+        int x = (int)particles->x[i];
+        int y = (int)particles->y[i];
+        canvas->backend->fillRectangle(canvas, x - 1, y - 1, x + 1, y + 1, particles->color[i]);
+    }
+}
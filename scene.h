@@ -0,0 +1,16 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "canvas.h"
+#include "game.h"
+
+// The playfield of a game drawn onto any canvas. Moving things are placed
+// between their previous and current tick by alpha, see InterpolateInt.
+void DrawShields(Canvas* canvas, const Game* game);
+void DrawPlayer(Canvas* canvas, const Game* game, double alpha);
+void DrawAliens(Canvas* canvas, const Game* game);
+void DrawBullets(Canvas* canvas, const Game* game, double alpha);
+void DrawExplosions(Canvas* canvas, const Game* game);
+void DrawParticles(Canvas* canvas, const Game* game);
+
+#endif
@@ -0,0 +1,58 @@
+#include "snapshot.h"
+
+#include <string.h>
+
+#include "particles.h"
+
+// CopyGame plus the live particles, which are all the renderer reads of them
+static void CopySnapshot(Snapshot* snapshot, const Game* game, int64_t timeNs) {
+    CopyGame(&snapshot->game, game);
+    const ParticleSystem* source = game->particles;
+    ParticleSystem* particles = snapshot->game.particles;
+    if (source != NULL && particles != NULL) {
+        size_t count = (size_t)source->pool.count;
+        memcpy(particles->x, source->x, sizeof(float) * count);
+        memcpy(particles->y, source->y, sizeof(float) * count);
+        memcpy(particles->color, source->color, sizeof(uint32_t) * count);
+        particles->pool = source->pool;
+    }
+    snapshot->timeNs = timeNs;
+}
+
+bool CreateSnapshotBuffer(SnapshotBuffer* buffer, const Game* game, int64_t timeNs) {
+    memset(buffer, 0, sizeof(SnapshotBuffer));
+    for (int i = 0; i < 3; i++) {
+        if (!CreateGame(&buffer->slots[i].game, &game->config)) {
+            DestroySnapshotBuffer(buffer);
+            return false;
+        }
+        CopySnapshot(&buffer->slots[i], game, timeNs);
+    }
+    buffer->back = 0;
+    buffer->ready = 1;
+    buffer->front = 2;
+    return true;
+}
+
+void DestroySnapshotBuffer(SnapshotBuffer* buffer) {
+    for (int i = 0; i < 3; i++) {
+        DestroyGame(&buffer->slots[i].game);
+    }
+}
+
+// The exchange releases the copy to the renderer and hands back whichever
+// slot it was not using
+void PublishSnapshot(SnapshotBuffer* buffer, const Game* game, int64_t timeNs) {
+    CopySnapshot(&buffer->slots[buffer->back], game, timeNs);
+    int previous = __atomic_exchange_n(&buffer->ready, buffer->back | SNAPSHOT_FRESH, __ATOMIC_ACQ_REL);
+    buffer->back = previous & ~SNAPSHOT_FRESH;
+    buffer->published++;
+}
+
+const Snapshot* AcquireSnapshot(SnapshotBuffer* buffer) {
+    if (__atomic_load_n(&buffer->ready, __ATOMIC_ACQUIRE) & SNAPSHOT_FRESH) {
+        int ready = __atomic_exchange_n(&buffer->ready, buffer->front, __ATOMIC_ACQ_REL);
+        buffer->front = ready & ~SNAPSHOT_FRESH;
+    }
+    return &buffer->slots[buffer->front];
+}
@@ -0,0 +1,42 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// A finished tick as the renderer sees it: a copy of the game, pool entries
+// and live particles included, and when it was published
+typedef struct {
+    Game game;
+    int64_t timeNs;
+} Snapshot;
+
+// Triple buffer between one simulation thread and one render thread. The
+// simulation fills its back slot and swaps it with the ready slot; the
+// renderer swaps its front slot with the ready one whenever that holds a
+// newer snapshot. Both swaps are single atomic exchanges, so neither side
+// ever waits for the other: a slow renderer only skips snapshots, and a
+// snapshot is never written while the renderer reads it.
+typedef struct {
+    Snapshot slots[3];
+    int back;   // simulation thread only
+    int front;  // render thread only
+    int ready;  // slot index, plus SNAPSHOT_FRESH until the renderer takes it
+    long published;
+} SnapshotBuffer;
+
+#define SNAPSHOT_FRESH 4
+
+// Every slot starts as a copy of the game, so there is always something to draw
+bool CreateSnapshotBuffer(SnapshotBuffer* buffer, const Game* game, int64_t timeNs);
+void DestroySnapshotBuffer(SnapshotBuffer* buffer);
+
+// Simulation thread, after each tick
+void PublishSnapshot(SnapshotBuffer* buffer, const Game* game, int64_t timeNs);
+
+// Render thread: the newest complete snapshot, valid until the next call
+const Snapshot* AcquireSnapshot(SnapshotBuffer* buffer);
+
+#endif
@@ -0,0 +1,361 @@
+#include "sprites.h"
+
+#include <stddef.h>
+
+// Explosions are drawn with the pen DrawBullets leaves selected
+#define EXPLOSION_OUTLINE FB_RGB(255, 100, 100)
+
+// Explosion cells are square around the explosion center
+#define EXPLOSION_CELL 64
+
+// Explosion particles: frame f has 8 + 2f particles spread evenly around
+// the center at distance 5 + 2f. The offsets are (int)(cos * distance) and
+// (int)(sin * distance) worked out once, so nothing calls the math library.
+#define EXPLOSION_MAX_PARTICLES (8 + (EXPLOSION_FRAMES - 1) * 2)
+
+static const int8_t explosionParticles[EXPLOSION_FRAMES][EXPLOSION_MAX_PARTICLES][2] = {
+    {
+        {5, 0}, {3, 3}, {0, 4}, {-3, 3}, {-4, 0}, {-3, -3}, {0, -4}, {3, -3},
+    },
+    {
+        {7, 0}, {5, 4}, {2, 6}, {-2, 6}, {-5, 4}, {-6, 0}, {-5, -4}, {-2, -6},
+        {2, -6}, {5, -4},
+    },
+    {
+        {9, 0}, {7, 4}, {4, 7}, {0, 8}, {-4, 7}, {-7, 4}, {-8, 0}, {-7, -4},
+        {-4, -7}, {0, -8}, {4, -7}, {7, -4},
+    },
+    {
+        {11, 0}, {9, 4}, {6, 8}, {2, 10}, {-2, 10}, {-6, 8}, {-9, 4}, {-10, 0},
+        {-9, -4}, {-6, -8}, {-2, -10}, {2, -10}, {6, -8}, {9, -4},
+    },
+    {
+        {13, 0}, {12, 4}, {9, 9}, {4, 12}, {0, 12}, {-4, 12}, {-9, 9}, {-12, 4},
+        {-12, 0}, {-12, -4}, {-9, -9}, {-4, -12}, {0, -12}, {4, -12}, {9, -9}, {12, -4},
+    },
+    {
+        {15, 0}, {14, 5}, {11, 9}, {7, 12}, {2, 14}, {-2, 14}, {-7, 12}, {-11, 9},
+        {-14, 5}, {-14, 0}, {-14, -5}, {-11, -9}, {-7, -12}, {-2, -14}, {2, -14}, {7, -12},
+        {11, -9}, {14, -5},
+    },
+    {
+        {17, 0}, {16, 5}, {13, 9}, {9, 13}, {5, 16}, {0, 16}, {-5, 16}, {-9, 13},
+        {-13, 9}, {-16, 5}, {-16, 0}, {-16, -5}, {-13, -9}, {-9, -13}, {-5, -16}, {0, -16},
+        {5, -16}, {9, -13}, {13, -9}, {16, -5},
+    },
+    {
+        {19, 0}, {18, 5}, {15, 10}, {12, 14}, {7, 17}, {2, 18}, {-2, 18}, {-7, 17},
+        {-12, 14}, {-15, 10}, {-18, 5}, {-18, 0}, {-18, -5}, {-15, -10}, {-12, -14}, {-7, -17},
+        {-2, -18}, {2, -18}, {7, -17}, {12, -14}, {15, -10}, {18, -5},
+    },
+};
+
+// Shape recording helpers
+static Shape* AddShape(ShapeList* list, ShapeKind kind, uint32_t fill, uint32_t pen) {
+    if (list->count >= SHAPE_LIST_CAPACITY) {
+        return NULL;
+    }
+    Shape* shape = &list->shapes[list->count++];
+    shape->kind = kind;
+    shape->pointCount = 0;
+    shape->fill = fill;
+    shape->pen = pen;
+    return shape;
+}
+
+static void AddBox(ShapeList* list, ShapeKind kind, int left, int top, int right, int bottom, uint32_t fill, uint32_t pen) {
+    Shape* shape = AddShape(list, kind, fill, pen);
+    if (shape != NULL) {
+        shape->coords[0] = left;
+        shape->coords[1] = top;
+        shape->coords[2] = right;
+        shape->coords[3] = bottom;
+    }
+}
+
+static void AddLine(ShapeList* list, int x0, int y0, int x1, int y1, uint32_t pen) {
+    AddBox(list, SHAPE_LINE, x0, y0, x1, y1, pen, pen);
+}
+
+static void AddTriangle(ShapeList* list, const int* points, uint32_t fill, uint32_t pen) {
+    Shape* shape = AddShape(list, SHAPE_POLYGON, fill, pen);
+    if (shape != NULL) {
+        shape->pointCount = 3;
+        for (int i = 0; i < 6; i++) {
+            shape->coords[i] = points[i];
+        }
+    }
+}
+
+// Alien designs, one per type
+void BuildAlienShapes(ShapeList* list, int type, int x, int y) {
+    uint32_t alienColor;
+    switch (type) {
+        case 0: alienColor = FB_RGB(255, 50, 50); break;  // Red
+        case 1: alienColor = FB_RGB(50, 150, 255); break; // Blue
+        case 2: alienColor = FB_RGB(255, 255, 50); break; // Yellow
+        default: alienColor = FB_RGB(255, 50, 255); break; // Purple
+    }
+    uint32_t white = FB_RGB(255, 255, 255);
+    uint32_t black = FB_RGB(0, 0, 0);
+
+    switch (type) {
+        case 0: // Type 1 - UFO shape
+            AddBox(list, SHAPE_ELLIPSE, x + 5, y + 10, x + ALIEN_WIDTH - 5, y + 30, alienColor, alienColor);
+            AddBox(list, SHAPE_RECTANGLE, x + 15, y + 5, x + ALIEN_WIDTH - 15, y + 10, alienColor, alienColor);
+
+            // Eyes and pupils
+            AddBox(list, SHAPE_ELLIPSE, x + 12, y + 15, x + 22, y + 25, white, alienColor);
+            AddBox(list, SHAPE_ELLIPSE, x + ALIEN_WIDTH - 22, y + 15, x + ALIEN_WIDTH - 12, y + 25, white, alienColor);
+            AddBox(list, SHAPE_ELLIPSE, x + 15, y + 18, x + 19, y + 22, black, alienColor);
+            AddBox(list, SHAPE_ELLIPSE, x + ALIEN_WIDTH - 19, y + 18, x + ALIEN_WIDTH - 15, y + 22, black, alienColor);
+
+            // Legs
+            AddLine(list, x + 10, y + 30, x + 5, y + ALIEN_HEIGHT - 5, alienColor);
+            AddLine(list, x + 20, y + 30, x + 15, y + ALIEN_HEIGHT - 5, alienColor);
+            AddLine(list, x + ALIEN_WIDTH - 20, y + 30, x + ALIEN_WIDTH - 15, y + ALIEN_HEIGHT - 5, alienColor);
+            AddLine(list, x + ALIEN_WIDTH - 10, y + 30, x + ALIEN_WIDTH - 5, y + ALIEN_HEIGHT - 5, alienColor);
+            break;
+
+        case 1: // Type 2 - Crab-like
+            AddBox(list, SHAPE_ELLIPSE, x + 10, y + 5, x + ALIEN_WIDTH - 10, y + 25, alienColor, alienColor);
+
+            // Eyes
+            AddBox(list, SHAPE_ELLIPSE, x + 15, y + 10, x + 22, y + 17, white, alienColor);
+            AddBox(list, SHAPE_ELLIPSE, x + ALIEN_WIDTH - 22, y + 10, x + ALIEN_WIDTH - 15, y + 17, white, alienColor);
+
+            // Claws
+            AddBox(list, SHAPE_ELLIPSE, x + 2, y + 15, x + 12, y + 25, alienColor, alienColor);
+            AddBox(list, SHAPE_ELLIPSE, x + ALIEN_WIDTH - 12, y + 15, x + ALIEN_WIDTH - 2, y + 25, alienColor, alienColor);
+
+            // Legs
+            AddLine(list, x + 15, y + 25, x + 10, y + ALIEN_HEIGHT - 5, alienColor);
+            AddLine(list, x + ALIEN_WIDTH/2 - 5, y + 25, x + ALIEN_WIDTH/2 - 10, y + ALIEN_HEIGHT - 5, alienColor);
+            AddLine(list, x + ALIEN_WIDTH/2 + 5, y + 25, x + ALIEN_WIDTH/2 + 10, y + ALIEN_HEIGHT - 5, alienColor);
+            AddLine(list, x + ALIEN_WIDTH - 15, y + 25, x + ALIEN_WIDTH - 10, y + ALIEN_HEIGHT - 5, alienColor);
+            break;
+
+        case 2: // Type 3 - Octopus-like
+            AddBox(list, SHAPE_ELLIPSE, x + 10, y + 5, x + ALIEN_WIDTH - 10, y + 25, alienColor, alienColor);
+
+            // Eyes
+            AddBox(list, SHAPE_ELLIPSE, x + 15, y + 10, x + 22, y + 17, white, alienColor);
+            AddBox(list, SHAPE_ELLIPSE, x + ALIEN_WIDTH - 22, y + 10, x + ALIEN_WIDTH - 15, y + 17, white, alienColor);
+
+            // Wavy tentacles
+            for (int i = 0; i < 8; i++) {
+                int startX = x + 10 + (i * (ALIEN_WIDTH - 20) / 7);
+                int penX = startX;
+                int penY = y + 25;
+                for (int j = 0; j < 3; j++) {
+                    int offsetX = (j % 2 == 0) ? 3 : -3;
+                    AddLine(list, penX, penY, startX + offsetX, y + 25 + (j+1) * 5, alienColor);
+                    penX = startX + offsetX;
+                    penY = y + 25 + (j+1) * 5;
+                }
+            }
+            break;
+    }
+}
+
+// Player ship
+void BuildPlayerShapes(ShapeList* list, int x, int y) {
+    uint32_t green = FB_RGB(0, 240, 0);
+
+    int shipBody[] = {
+        x + PLAYER_WIDTH/2, y,
+        x + PLAYER_WIDTH, y + PLAYER_HEIGHT,
+        x, y + PLAYER_HEIGHT
+    };
+    AddTriangle(list, shipBody, green, green);
+
+    int cockpit[] = {
+        x + PLAYER_WIDTH/2, y + 10,
+        x + PLAYER_WIDTH/2 + 10, y + PLAYER_HEIGHT - 10,
+        x + PLAYER_WIDTH/2 - 10, y + PLAYER_HEIGHT - 10
+    };
+    AddTriangle(list, cockpit, FB_RGB(150, 255, 150), green);
+}
+
+// One explosion frame centered on x, y
+void BuildExplosionShapes(ShapeList* list, int frame, int x, int y) {
+    static const uint32_t colors[] = {
+        FB_RGB(255, 255, 100),  // Yellow
+        FB_RGB(255, 150, 50),   // Orange
+        FB_RGB(255, 50, 50),    // Red
+        FB_RGB(200, 50, 50)     // Dark red
+    };
+
+    uint32_t color = colors[frame % 4];
+    int size = 20 - frame * 2;
+    if (size < 5) size = 5;
+
+    int particles = 8 + frame * 2;
+    for (int j = 0; j < particles; j++) {
+        int particleX = x + explosionParticles[frame][j][0];
+        int particleY = y + explosionParticles[frame][j][1];
+        AddBox(list, SHAPE_ELLIPSE,
+               particleX - size/2, particleY - size/2, particleX + size/2, particleY + size/2,
+               color, EXPLOSION_OUTLINE);
+    }
+
+    // Center
+    if (frame < 4) {
+        AddBox(list, SHAPE_ELLIPSE, x - 5, y - 5, x + 5, y + 5, FB_RGB(255, 255, 255), EXPLOSION_OUTLINE);
+    }
+}
+
+// Shapes of a sprite placed with its origin at x, y
+void BuildSpriteShapes(ShapeList* list, SpriteId sprite, int x, int y) {
+    if (sprite <= SPRITE_ALIEN_2) {
+        BuildAlienShapes(list, sprite - SPRITE_ALIEN_0, x, y);
+    } else if (sprite == SPRITE_PLAYER) {
+        BuildPlayerShapes(list, x, y);
+    } else {
+        BuildExplosionShapes(list, sprite - SPRITE_EXPLOSION_0, x, y);
+    }
+}
+
+// Rasterize shapes in order; alphaBits is OR-ed into every pixel written
+void DrawShapes(Framebuffer* fb, const ShapeList* list, uint32_t alphaBits) {
+    for (int i = 0; i < list->count; i++) {
+        const Shape* shape = &list->shapes[i];
+        const int* c = shape->coords;
+        uint32_t fill = shape->fill | alphaBits;
+        uint32_t pen = shape->pen | alphaBits;
+
+        switch (shape->kind) {
+            case SHAPE_RECTANGLE:
+                FillRectangle(fb, c[0], c[1], c[2], c[3], pen);
+                FillRectangle(fb, c[0] + 1, c[1] + 1, c[2] - 1, c[3] - 1, fill);
+                break;
+
+            case SHAPE_ELLIPSE:
+                FillEllipse(fb, c[0], c[1], c[2], c[3], pen);
+                FillEllipse(fb, c[0] + 1, c[1] + 1, c[2] - 1, c[3] - 1, fill);
+                break;
+
+            case SHAPE_POLYGON:
+                FillPolygon(fb, c, shape->pointCount, fill);
+                for (int p = 0; p < shape->pointCount; p++) {
+                    int q = (p + 1) % shape->pointCount;
+                    DrawLine(fb, c[p * 2], c[p * 2 + 1], c[q * 2], c[q * 2 + 1], pen);
+                }
+                break;
+
+            case SHAPE_LINE:
+                DrawLine(fb, c[0], c[1], c[2], c[3], pen);
+                break;
+        }
+    }
+}
+
+// Place every sprite in a single row of cells, one pixel apart
+void LayoutSprites(SpriteRect* rects, int* width, int* height) {
+    int x = 0;
+    int rowHeight = 0;
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        SpriteRect* rect = &rects[i];
+        if (i <= SPRITE_ALIEN_2) {
+            rect->width = ALIEN_WIDTH + 1;
+            rect->height = ALIEN_HEIGHT + 1;
+            rect->originX = 0;
+            rect->originY = 0;
+        } else if (i == SPRITE_PLAYER) {
+            rect->width = PLAYER_WIDTH + 1;
+            rect->height = PLAYER_HEIGHT + 1;
+            rect->originX = 0;
+            rect->originY = 0;
+        } else {
+            rect->width = EXPLOSION_CELL;
+            rect->height = EXPLOSION_CELL;
+            rect->originX = EXPLOSION_CELL / 2;
+            rect->originY = EXPLOSION_CELL / 2;
+        }
+        rect->x = x;
+        rect->y = 0;
+        x += rect->width + 1;
+        if (rect->height > rowHeight) rowHeight = rect->height;
+    }
+    *width = x;
+    *height = rowHeight;
+}
+
+// Rasterize every sprite once into a transparent atlas
+bool BuildSpriteAtlas(SpriteAtlas* atlas) {
+    int width, height;
+    LayoutSprites(atlas->rects, &width, &height);
+    if (!CreateFramebuffer(&atlas->image, width, height)) {
+        return false;
+    }
+    ClearFramebuffer(&atlas->image, 0);
+
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        const SpriteRect* rect = &atlas->rects[i];
+        ShapeList list;
+        list.count = 0;
+        BuildSpriteShapes(&list, (SpriteId)i, rect->x + rect->originX, rect->y + rect->originY);
+
+        // Draw into a view of the cell so nothing spills into a neighbour
+        Framebuffer cell = atlas->image;
+        cell.pixels = atlas->image.pixels + (size_t)rect->y * atlas->image.stride + rect->x;
+        cell.width = rect->width;
+        cell.height = rect->height;
+        for (int s = 0; s < list.count; s++) {
+            Shape* shape = &list.shapes[s];
+            int points = shape->kind == SHAPE_POLYGON ? shape->pointCount : 2;
+            for (int p = 0; p < points; p++) {
+                shape->coords[p * 2] -= rect->x;
+                shape->coords[p * 2 + 1] -= rect->y;
+            }
+        }
+        DrawShapes(&cell, &list, 0xFF000000u);
+    }
+    return true;
+}
+
+void FreeSpriteAtlas(SpriteAtlas* atlas) {
+    DestroyFramebuffer(&atlas->image);
+}
+
+// Copy the opaque pixels of an atlas cell with its origin at x, y
+static void BlitRect(Framebuffer* target, const SpriteAtlas* atlas, const SpriteRect* rect, int x, int y) {
+    int left = x - rect->originX;
+    int top = y - rect->originY;
+
+    int x0 = left < 0 ? -left : 0;
+    int y0 = top < 0 ? -top : 0;
+    int x1 = rect->width;
+    int y1 = rect->height;
+    if (left + x1 > target->width) x1 = target->width - left;
+    if (top + y1 > target->height) y1 = target->height - top;
+
+    for (int row = y0; row < y1; row++) {
+        const uint32_t* source = atlas->image.pixels + (size_t)(rect->y + row) * atlas->image.stride + rect->x;
+        uint32_t* dest = target->pixels + (size_t)(top + row) * target->stride + left;
+        for (int col = x0; col < x1; col++) {
+            // Alpha is 0x00 or 0xFF, so its top bit spreads into a select mask
+            uint32_t pixel = source[col];
+            uint32_t opaque = (uint32_t)-(int32_t)(pixel >> 31);
+            dest[col] = (dest[col] & ~opaque) | (pixel & opaque & 0x00FFFFFFu);
+        }
+    }
+}
+
+// Copy the opaque pixels of a sprite with its origin at x, y
+void BlitSprite(Framebuffer* target, const SpriteAtlas* atlas, SpriteId sprite, int x, int y) {
+    BlitRect(target, atlas, &atlas->rects[sprite], x, y);
+}
+
+// Draw explosions one frame at a time, so every blit of a batch reads the
+// same atlas cell. Explosions of a frame keep their pool order.
+void BlitExplosions(Framebuffer* target, const SpriteAtlas* atlas, const Explosion* explosions, int count) {
+    for (int frame = 0; frame < EXPLOSION_FRAMES; frame++) {
+        const SpriteRect* rect = &atlas->rects[SPRITE_EXPLOSION_0 + frame];
+        for (int i = 0; i < count; i++) {
+            if (explosions[i].frame == frame) {
+                BlitRect(target, atlas, rect, explosions[i].x, explosions[i].y);
+            }
+        }
+    }
+}
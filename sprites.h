@@ -0,0 +1,69 @@
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "framebuffer.h"
+#include "game.h"
+
+// Shape primitives, matching the GDI calls the sprites were designed with
+typedef enum {
+    SHAPE_RECTANGLE, // filled with fill, outlined with pen
+    SHAPE_ELLIPSE,   // filled with fill, outlined with pen
+    SHAPE_POLYGON,   // filled with fill, outlined with pen
+    SHAPE_LINE       // drawn with pen, end point excluded
+} ShapeKind;
+
+#define SHAPE_MAX_POINTS 4
+#define SHAPE_LIST_CAPACITY 48
+
+typedef struct {
+    ShapeKind kind;
+    int pointCount;                    // polygons only
+    uint32_t fill, pen;                // FB_RGB
+    int coords[SHAPE_MAX_POINTS * 2];  // left, top, right, bottom or x, y pairs
+} Shape;
+
+typedef struct {
+    Shape shapes[SHAPE_LIST_CAPACITY];
+    int count;
+} ShapeList;
+
+// Everything that is drawn from the atlas
+typedef enum {
+    SPRITE_ALIEN_0,
+    SPRITE_ALIEN_1,
+    SPRITE_ALIEN_2,
+    SPRITE_PLAYER,
+    SPRITE_EXPLOSION_0, // one sprite per explosion frame
+    SPRITE_COUNT = SPRITE_EXPLOSION_0 + EXPLOSION_FRAMES
+} SpriteId;
+
+// Where a sprite lives in the atlas. The origin is the point inside the cell
+// that lands on the entity position (top-left for ships, center for explosions).
+typedef struct {
+    int x, y;
+    int width, height;
+    int originX, originY;
+} SpriteRect;
+
+// Pre-rasterized sprites; pixels with a zero alpha byte are transparent
+typedef struct {
+    Framebuffer image;
+    SpriteRect rects[SPRITE_COUNT];
+} SpriteAtlas;
+
+void BuildAlienShapes(ShapeList* list, int type, int x, int y);
+void BuildPlayerShapes(ShapeList* list, int x, int y);
+void BuildExplosionShapes(ShapeList* list, int frame, int x, int y);
+void BuildSpriteShapes(ShapeList* list, SpriteId sprite, int x, int y);
+void DrawShapes(Framebuffer* fb, const ShapeList* list, uint32_t alphaBits);
+
+void LayoutSprites(SpriteRect* rects, int* width, int* height);
+bool BuildSpriteAtlas(SpriteAtlas* atlas);
+void FreeSpriteAtlas(SpriteAtlas* atlas);
+void BlitSprite(Framebuffer* target, const SpriteAtlas* atlas, SpriteId sprite, int x, int y);
+void BlitExplosions(Framebuffer* target, const SpriteAtlas* atlas, const Explosion* explosions, int count);
+
+#endif